@@ -0,0 +1,412 @@
+#include <algorithm>
+#include <cstring>
+#include "array_kernels.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+/******************/
+/* Scalar Kernels */
+/******************/
+
+static bool scalar_sum_int(const int64_t *a, size_t n, int64_t *sum) {
+  __int128 acc = 0;
+  for (size_t i = 0; i < n; i++) {
+    acc += a[i];
+  }
+  if (acc < INT64_MIN || acc > INT64_MAX) {
+    return false;
+  }
+  *sum = (int64_t)acc;
+  return true;
+}
+
+static double scalar_sum_float(const double *a, size_t n) {
+  double acc = 0;
+  for (size_t i = 0; i < n; i++) {
+    acc += a[i];
+  }
+  return acc;
+}
+
+static int64_t scalar_min_int(const int64_t *a, size_t n) {
+  int64_t m = a[0];
+  for (size_t i = 1; i < n; i++) {
+    m = a[i] < m ? a[i] : m;
+  }
+  return m;
+}
+
+static int64_t scalar_max_int(const int64_t *a, size_t n) {
+  int64_t m = a[0];
+  for (size_t i = 1; i < n; i++) {
+    m = a[i] > m ? a[i] : m;
+  }
+  return m;
+}
+
+static double scalar_min_float(const double *a, size_t n) {
+  double m = a[0];
+  for (size_t i = 1; i < n; i++) {
+    m = a[i] < m ? a[i] : m;
+  }
+  return m;
+}
+
+static double scalar_max_float(const double *a, size_t n) {
+  double m = a[0];
+  for (size_t i = 1; i < n; i++) {
+    m = a[i] > m ? a[i] : m;
+  }
+  return m;
+}
+
+static double scalar_dot_float(const double *a, const double *b, size_t n) {
+  double acc = 0;
+  for (size_t i = 0; i < n; i++) {
+    acc += a[i] * b[i];
+  }
+  return acc;
+}
+
+static void scalar_scale_float(const double *a, double k, double *out, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    out[i] = a[i] * k;
+  }
+}
+
+static void scalar_add_float(const double *a, const double *b, double *out, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    out[i] = a[i] + b[i];
+  }
+}
+
+static void scalar_mul_float(const double *a, const double *b, double *out, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    out[i] = a[i] * b[i];
+  }
+}
+
+static bool scalar_add_int(const int64_t *a, const int64_t *b, int64_t *out, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    if (__builtin_add_overflow(a[i], b[i], &out[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void scalar_and_int(const int64_t *a, const int64_t *b, int64_t *out, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    out[i] = a[i] & b[i];
+  }
+}
+
+static void scalar_or_int(const int64_t *a, const int64_t *b, int64_t *out, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    out[i] = a[i] | b[i];
+  }
+}
+
+static void scalar_xor_int(const int64_t *a, const int64_t *b, int64_t *out, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    out[i] = a[i] ^ b[i];
+  }
+}
+
+static void scalar_shift_left(const int64_t *a, unsigned count, int64_t *out, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    out[i] = (int64_t)((uint64_t)a[i] << count);
+  }
+}
+
+static void scalar_shift_right(const int64_t *a, unsigned count, int64_t *out, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    out[i] = a[i] >> count;
+  }
+}
+
+static const Array_Kernels scalar_kernels = {
+  "scalar",
+  scalar_sum_int, scalar_sum_float,
+  scalar_min_int, scalar_max_int, scalar_min_float, scalar_max_float,
+  scalar_dot_float,
+  scalar_scale_float, scalar_add_float, scalar_mul_float,
+  scalar_add_int, scalar_and_int, scalar_or_int, scalar_xor_int,
+  scalar_shift_left, scalar_shift_right,
+};
+
+/****************/
+/* AVX2 Kernels */
+/****************/
+
+#if defined(__x86_64__)
+
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 static double horizontal_sum(__m256d v) {
+  __m128d lo = _mm256_castpd256_pd128(v);
+  __m128d hi = _mm256_extractf128_pd(v, 1);
+  lo = _mm_add_pd(lo, hi);
+  return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+}
+
+// Each lane sums its own elements, a lane that overflows is caught from
+// the signs: adding two numbers of the same sign gave the other sign. The
+// exact scalar sum decides when one did, the total may still fit.
+AVX2 static bool avx2_sum_int(const int64_t *a, size_t n, int64_t *sum) {
+  __m256i acc = _mm256_setzero_si256();
+  __m256i overflow = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(a + i));
+    __m256i s = _mm256_add_epi64(acc, v);
+    overflow = _mm256_or_si256(overflow,
+			       _mm256_and_si256(_mm256_xor_si256(acc, s), _mm256_xor_si256(v, s)));
+    acc = s;
+  }
+  if (_mm256_movemask_pd(_mm256_castsi256_pd(overflow)) != 0) {
+    return scalar_sum_int(a, n, sum);
+  }
+  int64_t lanes[4];
+  _mm256_storeu_si256((__m256i *)lanes, acc);
+  int64_t total = 0;
+  for (int64_t lane : lanes) {
+    if (__builtin_add_overflow(total, lane, &total)) {
+      return scalar_sum_int(a, n, sum);
+    }
+  }
+  for (; i < n; i++) {
+    if (__builtin_add_overflow(total, a[i], &total)) {
+      return scalar_sum_int(a, n, sum);
+    }
+  }
+  *sum = total;
+  return true;
+}
+
+// four accumulators hide the latency of the adds
+AVX2 static double avx2_sum_float(const double *a, size_t n) {
+  __m256d acc0 = _mm256_setzero_pd();
+  __m256d acc1 = _mm256_setzero_pd();
+  __m256d acc2 = _mm256_setzero_pd();
+  __m256d acc3 = _mm256_setzero_pd();
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(a + i));
+    acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(a + i + 4));
+    acc2 = _mm256_add_pd(acc2, _mm256_loadu_pd(a + i + 8));
+    acc3 = _mm256_add_pd(acc3, _mm256_loadu_pd(a + i + 12));
+  }
+  for (; i + 4 <= n; i += 4) {
+    acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(a + i));
+  }
+  double total = horizontal_sum(_mm256_add_pd(_mm256_add_pd(acc0, acc1), _mm256_add_pd(acc2, acc3)));
+  for (; i < n; i++) {
+    total += a[i];
+  }
+  return total;
+}
+
+AVX2 static int64_t avx2_min_int(const int64_t *a, size_t n) {
+  if (n < 4) {
+    return scalar_min_int(a, n);
+  }
+  __m256i m = _mm256_loadu_si256((const __m256i *)a);
+  size_t i = 4;
+  for (; i + 4 <= n; i += 4) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(a + i));
+    m = _mm256_blendv_epi8(m, v, _mm256_cmpgt_epi64(m, v));
+  }
+  int64_t lanes[4];
+  _mm256_storeu_si256((__m256i *)lanes, m);
+  int64_t result = scalar_min_int(lanes, 4);
+  return (i < n) ? std::min(result, scalar_min_int(a + i, n - i)) : result;
+}
+
+AVX2 static int64_t avx2_max_int(const int64_t *a, size_t n) {
+  if (n < 4) {
+    return scalar_max_int(a, n);
+  }
+  __m256i m = _mm256_loadu_si256((const __m256i *)a);
+  size_t i = 4;
+  for (; i + 4 <= n; i += 4) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(a + i));
+    m = _mm256_blendv_epi8(m, v, _mm256_cmpgt_epi64(v, m));
+  }
+  int64_t lanes[4];
+  _mm256_storeu_si256((__m256i *)lanes, m);
+  int64_t result = scalar_max_int(lanes, 4);
+  return (i < n) ? std::max(result, scalar_max_int(a + i, n - i)) : result;
+}
+
+AVX2 static double avx2_min_float(const double *a, size_t n) {
+  if (n < 4) {
+    return scalar_min_float(a, n);
+  }
+  __m256d m = _mm256_loadu_pd(a);
+  size_t i = 4;
+  for (; i + 4 <= n; i += 4) {
+    m = _mm256_min_pd(m, _mm256_loadu_pd(a + i));
+  }
+  double lanes[4];
+  _mm256_storeu_pd(lanes, m);
+  double result = scalar_min_float(lanes, 4);
+  return (i < n) ? std::min(result, scalar_min_float(a + i, n - i)) : result;
+}
+
+AVX2 static double avx2_max_float(const double *a, size_t n) {
+  if (n < 4) {
+    return scalar_max_float(a, n);
+  }
+  __m256d m = _mm256_loadu_pd(a);
+  size_t i = 4;
+  for (; i + 4 <= n; i += 4) {
+    m = _mm256_max_pd(m, _mm256_loadu_pd(a + i));
+  }
+  double lanes[4];
+  _mm256_storeu_pd(lanes, m);
+  double result = scalar_max_float(lanes, 4);
+  return (i < n) ? std::max(result, scalar_max_float(a + i, n - i)) : result;
+}
+
+AVX2 static double avx2_dot_float(const double *a, const double *b, size_t n) {
+  __m256d acc0 = _mm256_setzero_pd();
+  __m256d acc1 = _mm256_setzero_pd();
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4)));
+  }
+  double total = horizontal_sum(_mm256_add_pd(acc0, acc1));
+  for (; i < n; i++) {
+    total += a[i] * b[i];
+  }
+  return total;
+}
+
+AVX2 static void avx2_scale_float(const double *a, double k, double *out, size_t n) {
+  __m256d vk = _mm256_set1_pd(k);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(a + i), vk));
+  }
+  scalar_scale_float(a + i, k, out + i, n - i);
+}
+
+AVX2 static void avx2_add_float(const double *a, const double *b, double *out, size_t n) {
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+  }
+  scalar_add_float(a + i, b + i, out + i, n - i);
+}
+
+AVX2 static void avx2_mul_float(const double *a, const double *b, double *out, size_t n) {
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+  }
+  scalar_mul_float(a + i, b + i, out + i, n - i);
+}
+
+AVX2 static bool avx2_add_int(const int64_t *a, const int64_t *b, int64_t *out, size_t n) {
+  __m256i overflow = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+    __m256i vb = _mm256_loadu_si256((const __m256i *)(b + i));
+    __m256i s = _mm256_add_epi64(va, vb);
+    overflow = _mm256_or_si256(overflow,
+			       _mm256_and_si256(_mm256_xor_si256(va, s), _mm256_xor_si256(vb, s)));
+    _mm256_storeu_si256((__m256i *)(out + i), s);
+  }
+  if (_mm256_movemask_pd(_mm256_castsi256_pd(overflow)) != 0) {
+    return false;
+  }
+  return scalar_add_int(a + i, b + i, out + i, n - i);
+}
+
+#define AVX2_BITWISE(NAME, INTRINSIC)					\
+  AVX2 static void avx2_##NAME(const int64_t *a, const int64_t *b, int64_t *out, size_t n) { \
+    size_t i = 0;							\
+    for (; i + 4 <= n; i += 4) {					\
+      __m256i va = _mm256_loadu_si256((const __m256i *)(a + i));	\
+      __m256i vb = _mm256_loadu_si256((const __m256i *)(b + i));	\
+      _mm256_storeu_si256((__m256i *)(out + i), INTRINSIC(va, vb));	\
+    }									\
+    scalar_##NAME(a + i, b + i, out + i, n - i);			\
+  }
+
+AVX2_BITWISE(and_int, _mm256_and_si256)
+AVX2_BITWISE(or_int, _mm256_or_si256)
+AVX2_BITWISE(xor_int, _mm256_xor_si256)
+
+AVX2 static void avx2_shift_left(const int64_t *a, unsigned count, int64_t *out, size_t n) {
+  __m128i c = _mm_cvtsi32_si128(count);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(a + i));
+    _mm256_storeu_si256((__m256i *)(out + i), _mm256_sll_epi64(v, c));
+  }
+  scalar_shift_left(a + i, count, out + i, n - i);
+}
+
+// AVX2 only shifts 64 bit lanes logically, the sign is filled in from a
+// mask of the negative lanes shifted the other way
+AVX2 static void avx2_shift_right(const int64_t *a, unsigned count, int64_t *out, size_t n) {
+  __m128i c = _mm_cvtsi32_si128(count);
+  __m128i fill = _mm_cvtsi32_si128(64 - count);
+  __m256i zero = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(a + i));
+    __m256i sign = _mm256_cmpgt_epi64(zero, v);
+    __m256i shifted = _mm256_or_si256(_mm256_srl_epi64(v, c), _mm256_sll_epi64(sign, fill));
+    _mm256_storeu_si256((__m256i *)(out + i), shifted);
+  }
+  scalar_shift_right(a + i, count, out + i, n - i);
+}
+
+static const Array_Kernels avx2_kernels = {
+  "avx2",
+  avx2_sum_int, avx2_sum_float,
+  avx2_min_int, avx2_max_int, avx2_min_float, avx2_max_float,
+  avx2_dot_float,
+  avx2_scale_float, avx2_add_float, avx2_mul_float,
+  avx2_add_int, avx2_and_int, avx2_or_int, avx2_xor_int,
+  avx2_shift_left, avx2_shift_right,
+};
+
+static bool has_avx2() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+
+#endif
+
+static const Array_Kernels *default_kernels() {
+#if defined(__x86_64__)
+  if (has_avx2()) {
+    return &avx2_kernels;
+  }
+#endif
+  return &scalar_kernels;
+}
+
+const Array_Kernels *array_kernels = default_kernels();
+
+bool select_array_kernels(const char *name) {
+  if (strcmp(name, "scalar") == 0) {
+    array_kernels = &scalar_kernels;
+    return true;
+  }
+#if defined(__x86_64__)
+  if (strcmp(name, "avx2") == 0 && has_avx2()) {
+    array_kernels = &avx2_kernels;
+    return true;
+  }
+#endif
+  return false;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Loops behind the packed array builtins, see builtin_array.h.
+//
+// There are two sets: AVX2 kernels written with intrinsics, and plain loops
+// that work anywhere and that the compiler vectorizes with SSE2 when
+// optimizing. The AVX2 set is picked at startup when the CPU has it.
+// Float reductions add lanes separately, so their results may differ from
+// a left to right sum in the last bits. Integer kernels that can overflow
+// return false instead of wrapping. There is no 64 bit multiply in AVX2,
+// integer products are left to the builtins.
+
+struct Array_Kernels {
+  const char *name;
+
+  // false if the sum doesn't fit in 64 bits
+  bool (*sum_int)(const int64_t *a, size_t n, int64_t *sum);
+  double (*sum_float)(const double *a, size_t n);
+  // n must be at least 1
+  int64_t (*min_int)(const int64_t *a, size_t n);
+  int64_t (*max_int)(const int64_t *a, size_t n);
+  double (*min_float)(const double *a, size_t n);
+  double (*max_float)(const double *a, size_t n);
+  double (*dot_float)(const double *a, const double *b, size_t n);
+
+  // elementwise into out, which may be a or b
+  void (*scale_float)(const double *a, double k, double *out, size_t n);
+  void (*add_float)(const double *a, const double *b, double *out, size_t n);
+  void (*mul_float)(const double *a, const double *b, double *out, size_t n);
+  // false if an element overflows, out is left partly written
+  bool (*add_int)(const int64_t *a, const int64_t *b, int64_t *out, size_t n);
+  void (*and_int)(const int64_t *a, const int64_t *b, int64_t *out, size_t n);
+  void (*or_int)(const int64_t *a, const int64_t *b, int64_t *out, size_t n);
+  void (*xor_int)(const int64_t *a, const int64_t *b, int64_t *out, size_t n);
+  // count is 0 to 63, shift_right is arithmetic like >>
+  void (*shift_left)(const int64_t *a, unsigned count, int64_t *out, size_t n);
+  void (*shift_right)(const int64_t *a, unsigned count, int64_t *out, size_t n);
+};
+
+extern const Array_Kernels *array_kernels;
+
+// selects the kernels by name, "avx2" or "scalar", false if the CPU can't
+// run them
+bool select_array_kernels(const char *name);
@@ -0,0 +1,146 @@
+#include <unordered_map>
+#include "backtick.h"
+#include "interp.h"
+#include "interp_exceptions.h"
+#include "builtin_helpers.h"
+
+enum Template_Kind : uint8_t {
+  TEMPLATE_CONSTANT,  // shared with the template
+  TEMPLATE_UNQUOTE,   // ,node
+  TEMPLATE_SPLICE,    // ,@node
+  TEMPLATE_LIST,      // a list with holes, built by list
+};
+
+struct Template {
+  struct Element {
+    Template_Kind kind;
+    Parse_Node *node;
+    Template *list;
+  };
+  std::vector<Element> elements;
+
+  Template() {}
+  ~Template() {
+    for (Element &e : elements) {
+      delete e.list;
+    }
+  }
+  Template(const Template &) = delete;
+  Template &operator=(const Template &) = delete;
+};
+
+static std::unordered_map<Parse_Node *, Template *> templates;
+
+// nullptr when the list has no holes
+static Template *compile_template(Parse_Node *list) {
+  Template *t = new Template();
+  bool holes = false;
+  for (; !is_empty_list(list); list = list->next) {
+    Parse_Node *elem = list->first;
+    switch (node_subtype(elem)) {
+    case SYNTAX_COMMA:
+      t->elements.push_back({TEMPLATE_UNQUOTE, elem->first, nullptr});
+      holes = true;
+      continue;
+    case SYNTAX_COMMA_AT:
+      t->elements.push_back({TEMPLATE_SPLICE, elem->first, nullptr});
+      holes = true;
+      continue;
+    default:
+      break;
+    }
+    Template *sub = is_list(elem) ? compile_template(elem) : nullptr;
+    if (sub != nullptr) {
+      t->elements.push_back({TEMPLATE_LIST, elem, sub});
+      holes = true;
+    } else {
+      t->elements.push_back({TEMPLATE_CONSTANT, elem, nullptr});
+    }
+  }
+  if (!holes) {
+    delete t;
+    return nullptr;
+  }
+  return t;
+}
+
+static Parse_Node *run_template(Template *t, Symbol_Table *env) {
+  Parse_Node *ret = new Parse_Node{PARSE_NODE_LIST};
+  Parse_Node *tail = ret;
+  auto push = [&tail](Parse_Node *value) {
+    tail->first = value;
+    tail->next = new Parse_Node{PARSE_NODE_LIST};
+    tail = tail->next;
+  };
+
+  for (Template::Element &e : t->elements) {
+    Parse_Node *value;
+    switch (e.kind) {
+    case TEMPLATE_CONSTANT:
+      push(e.node);
+      continue;
+    case TEMPLATE_LIST:
+      value = run_template(e.list, env);
+      break;
+    default:
+      value = eval_parse_node(e.node, env);
+      break;
+    }
+    if (is_return(value)) {
+      return value;
+    }
+    if (e.kind != TEMPLATE_SPLICE) {
+      push(value);
+      continue;
+    }
+    if (!is_list(value)) {
+      throw runtimeError("Error: ,@ can only be used with list, "
+			 + print_node(e.node) +
+			 " is not a list\n");
+    }
+    for (; !is_empty_list(value); value = value->next) {
+      push(value->first);
+    }
+  }
+  return ret;
+}
+
+Parse_Node *eval_backtick(Parse_Node *node, Symbol_Table *env) {
+  Parse_Node *body = node->first;
+  if (node_subtype(body) == SYNTAX_COMMA) {
+    return eval_parse_node(body->first, env);
+  }
+  if (!is_list(body)) {
+    return body;
+  }
+
+  Template *t = nullptr;
+  if (node->flags & NODE_HAS_TEMPLATE) {
+    auto it = templates.find(node);
+    if (it != templates.end()) {
+      t = it->second;
+    }
+  }
+  if (t == nullptr) {
+    t = compile_template(body);
+    if (t == nullptr) {
+      // a list without holes still gives a new list, it's only the elements
+      // that are shared
+      t = new Template();
+      for (Parse_Node *elem = body; !is_empty_list(elem); elem = elem->next) {
+	t->elements.push_back({TEMPLATE_CONSTANT, elem->first, nullptr});
+      }
+    }
+    templates[node] = t;
+    node->flags |= NODE_HAS_TEMPLATE;
+  }
+  return run_template(t, env);
+}
+
+void backtick_forget(Parse_Node *node) {
+  auto it = templates.find(node);
+  if (it != templates.end()) {
+    delete it->second;
+    templates.erase(it);
+  }
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include "parser.h"
+
+// Backtick templates.
+//
+// The first time a backtick form is evaluated its template is compiled into
+// a plan: a list template becomes the sequence of its elements, each one a
+// constant, a , or ,@ hole, or a nested list that has holes of its own. Running
+// the plan only evaluates the holes and builds the spines of the lists that
+// have them. Elements without holes are shared with the template, the same
+// way quote returns its argument, while every list with a hole is built
+// fresh so the result can be modified. The plan is dropped when the backtick
+// node is collected.
+
+// node is the SYNTAX_BACKTICK node
+Parse_Node *eval_backtick(Parse_Node *node, Symbol_Table *env);
+
+// called by the collector when a node with NODE_HAS_TEMPLATE is freed
+void backtick_forget(Parse_Node *node);
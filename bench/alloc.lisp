@@ -0,0 +1,22 @@
+; Allocation heavy workload for comparing the heap allocators:
+;   time ./pl bench/alloc.lisp
+;   time ./pl --allocator=malloc bench/alloc.lisp
+
+(defun build-list (n)
+  (let ((acc '()))
+    (while (> n 0)
+      (set acc (push n acc))
+      (dec n))
+    acc))
+
+(defun template (a b)
+  `(a ,a (b ,b) ,@(list a b)))
+
+(let ((i 0) (total 0))
+  (while (< i 2000)
+    (set total (+ total (length (copy (build-list 100)))))
+    (template i total)
+    (inc i))
+  total)
+
+(gc-stats)
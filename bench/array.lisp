@@ -0,0 +1,18 @@
+; Reductions over a million doubles and integers, compare the AVX2 kernels
+; with the scalar loops:
+;   time ./pl bench/array.lisp
+;   time ./pl --array-kernels=scalar bench/array.lisp
+
+(defsym n 1000000)
+(defsym xs (make-float-array n 1.5))
+(defsym ys (make-float-array n 2))
+(defsym is (make-int-array n 3))
+
+(defun run (k acc)
+  (if (= k 0)
+      acc
+      (run (- k 1)
+	   (+ acc (array-sum xs) (array-dot xs ys) (array-max ys)
+	      (array-sum is) (array-min is)))))
+
+(print (run 1000 0))
@@ -0,0 +1,13 @@
+; Backtick templates built at run time, most of each template is constant:
+;   time ./pl bench/backtick.lisp
+
+(defun make-form (test forms)
+  `(if ,test
+       (progn ,@forms (log "done" (quote (a b c))))
+       (progn (log "skipped" (quote (d e f))) ,test)))
+
+(let ((i 0) (forms (list 1 2 3)) (n 0))
+  (while (< i 100000)
+    (set n (+ n (length (make-form i forms))))
+    (set i (+ i 1)))
+  (print n))
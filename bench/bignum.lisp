@@ -0,0 +1,32 @@
+; Integers past 64 bits: long additions, products of a few thousand digit
+; numbers, which go through Karatsuba multiplication, and decimal printing
+; and parsing of the results:
+;   time ./pl bench/bignum.lisp
+
+(defun fact (n)
+  (let ((acc 1) (i 2))
+    (while (<= i n)
+      (set acc (* acc i))
+      (set i (+ i 1)))
+    acc))
+
+(defun fib (n)
+  (let ((a 0) (b 1) (i 0))
+    (while (< i n)
+      (let ((next (+ a b)))
+	(set a b)
+	(set b next))
+      (set i (+ i 1)))
+    a))
+
+(defun square-times (x n)
+  (let ((i 0))
+    (while (< i n)
+      (* x x)
+      (set i (+ i 1)))
+    x))
+
+(defsym f (fact 3000))
+(print (= (square-times f 200) f))
+(print (< (fib 20000) f))
+(print f)
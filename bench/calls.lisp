@@ -0,0 +1,11 @@
+; Calls evaluated by the tree-walker, the operator lookups hit the
+; call site cache:
+;   time ./pl --engine=tree bench/calls.lisp
+
+(defun fib (n)
+  (if (< n 2)
+      n
+      (+ (fib (- n 1)) (fib (- n 2)))))
+
+(print (fib 25))
+(print (call-cache-stats))
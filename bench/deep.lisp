@@ -0,0 +1,17 @@
+; Non tail recursion. The vm keeps its calls on a heap allocated frame
+; stack, the other engines recurse on the native stack and report
+; "stack exhausted" long before the last call:
+;   time ./pl --engine=vm bench/deep.lisp
+;   time ./pl --engine=closure bench/deep.lisp
+
+(defun deep (n)
+  (if (= n 0)
+      0
+      (+ 1 (deep (- n 1)))))
+
+(let ((i 0))
+  (while (< i 100)
+    (deep 2000)
+    (inc i)))
+
+(print (deep 200000))
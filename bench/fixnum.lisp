@@ -0,0 +1,16 @@
+; Integer arithmetic that stays within 64 bits, through the engines'
+; fixnum paths and through the builtins, boxed values included. It should
+; run as fast with bignum promotion as it did without:
+;   time ./pl bench/fixnum.lisp
+
+(defun run (n)
+  (let ((i 0) (acc 0) (wide 4611686018427387904))
+    (while (< i n)
+      (set acc (+ acc (* i 3 2) (- i 7)))
+      (+ wide i 1)
+      (- wide i 1)
+      (* i 1 2 3 4 5 6)
+      (set i (+ i 1)))
+    acc))
+
+(print (run 200000))
@@ -0,0 +1,13 @@
+; Constant subexpressions in a hot loop, folded before the loop runs:
+;   time ./pl bench/fold.lisp
+
+(defun mask-sum (n)
+  (let ((i 0) (sum 0))
+    (while (< i n)
+      (set sum (+ sum (& i (- (<< 1 8) 1)) (* 2 3 7)))
+      (if (> (* 1024 1024) 1000)
+	  (set i (+ i 1))
+	  (set i (+ i 2))))
+    sum))
+
+(print (mask-sum 200000))
@@ -0,0 +1,21 @@
+; 10M hash table operations: 5M inserts of integer keys, growing the table
+; from empty, then 5M lookups of the same keys:
+;   time ./pl bench/hash.lisp
+
+(defun fill (h n)
+  (let ((i 0))
+    (while (< i n)
+      (hash-set h (* i 7919) i)
+      (set i (+ i 1)))
+    h))
+
+(defun lookup (h n)
+  (let ((i 0) (acc 0))
+    (while (< i n)
+      (set acc (+ acc (hash-get h (* i 7919))))
+      (set i (+ i 1)))
+    acc))
+
+(defsym table (fill (make-hash) 5000000))
+(print (hash-count table))
+(print (lookup table 5000000))
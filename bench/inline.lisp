@@ -0,0 +1,16 @@
+; Calls to small helpers in a hot loop, inlined by the closure engine:
+;   time ./pl --report-inlining bench/inline.lisp
+
+(defun max2 (a b) (if (> a b) a b))
+(defun square (x) (* x x))
+(defun small? (x) (< x 100))
+
+(defun run (n)
+  (let ((i 0) (best 0) (small 0))
+    (while (< i n)
+      (set best (max2 best (square (- (& i 1023) 512))))
+      (if (small? i) (set small (+ small 1)))
+      (set i (+ i 1)))
+    (list best small)))
+
+(print (run 200000))
@@ -0,0 +1,14 @@
+; Building a list with append and checking its length as it grows. Both
+; used to walk the whole list, with the cached header each is constant time
+; and the loop is linear:
+;   time ./pl bench/list.lisp
+
+(defun build (n)
+  (let ((l (list)) (i 0))
+    (while (< i n)
+      (append i l)
+      (if (< (length l) 0) (print "unreachable"))
+      (set i (+ i 1)))
+    l))
+
+(print (length (build 20000)))
@@ -0,0 +1,16 @@
+; macro calls in a hot loop, at top level the loop is run by the
+; tree-walker under every engine
+
+(let ((i 0) (odd 0))
+  (while (< i 200000)
+    (when (= (& i 1) 1)
+      (inc odd))
+    (inc i))
+  (print odd))
+
+(let ((total 0))
+  (for ((i 0) (< i 1000) (inc i))
+    (for ((j 0) (< j 100) (inc j))
+      (unless (= j 0)
+	(inc total 2))))
+  (print total))
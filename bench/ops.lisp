@@ -0,0 +1,23 @@
+; Arithmetic and comparison operators with three or more integer, mixed
+; and float arguments, which go through the builtins rather than the
+; engines' two argument fixnum paths. Each operator gets its own loop,
+; defined by a macro so the call sites name the operator directly, and
+; its own time in microseconds:
+;   ./pl bench/ops.lisp
+
+(defmacro defrun (op)
+  `(defun run (n)
+     (let ((i 0) (o 1) (h 0.5) (q 0.25))
+       (while (< i n)
+	 (,op i 3 2)
+	 (,op i h 2)
+	 (,op h q h)
+	 (,op o o o o o o)
+	 (set i (+ i 1)))
+       i)))
+
+(for-each (op '(+ - * = < <= > >=))
+  (eval (list 'defrun op))
+  (let ((start (clock-us)))
+    (run 100000)
+    (print (list op (- (clock-us) start)))))
@@ -0,0 +1,19 @@
+; Calls through optional and rest parameters, which the closure compiler
+; and the vm leave to the generic binder:
+;   time ./pl bench/params.lisp
+
+(defun step (acc &opt (by 1) &rest more)
+  (if (empty? more)
+      (+ acc by)
+      (+ acc by (first more))))
+
+(defun run (n)
+  (let ((i 0) (acc 0))
+    (while (< i n)
+      (set acc (step acc))
+      (set acc (step acc 2))
+      (set acc (step acc 2 3))
+      (set i (+ i 1)))
+    acc))
+
+(print (run 60000))
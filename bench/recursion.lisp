@@ -0,0 +1,17 @@
+; Deeply recursive calls, variable lookup cost shouldn't grow with the call depth:
+;   time ./pl bench/recursion.lisp
+
+(defun fib (n)
+  (if (< n 2)
+      n
+      (+ (fib (- n 1)) (fib (- n 2)))))
+
+(defun tak (x y z)
+  (if (not (< y x))
+      z
+      (tak (tak (- x 1) y z)
+	   (tak (- y 1) z x)
+	   (tak (- z 1) x y))))
+
+(print (fib 22))
+(print (tak 18 12 6))
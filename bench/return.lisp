@@ -0,0 +1,20 @@
+; Early returns from small hot functions, return used to unwind the C++ stack:
+;   time ./pl bench/return.lisp
+;   time ./pl --engine=tree bench/return.lisp
+
+(defun clamp (x lo hi)
+  (when (< x lo) (return lo))
+  (when (> x hi) (return hi))
+  x)
+
+(defun find-first-over (limit xs)
+  (for-each (x xs)
+	    (when (> x limit) (return x)))
+  '())
+
+(let ((i 0) (total 0) (xs '(1 2 3 4 5 6 7 8 9 10)))
+  (while (< i 20000)
+    (set total (+ total (max 3 i) (min i 7) (clamp i 100 200)))
+    (set total (+ total (find-first-over 5 xs)))
+    (inc i))
+  (print total))
@@ -0,0 +1,19 @@
+; Tail recursive loops, they run in constant C++ stack:
+;   time ./pl bench/tail.lisp
+
+(defun count-down (n acc)
+  (if (= n 0)
+      acc
+      (count-down (- n 1) (+ acc 1))))
+
+(defun even-odd (n)
+  (cond ((= n 0) :even)
+	(true (odd-even (- n 1)))))
+
+(defun odd-even (n)
+  (when (= n 0) (return :odd))
+  (let ((m (- n 1)))
+    (progn (even-odd m))))
+
+(print (count-down 10000000 0))
+(print (even-odd 1000001))
@@ -0,0 +1,21 @@
+; Filling a sequence with append and then reading it back by index, once
+; as a list and once as a vector. Every append and nth walks the list, the
+; vector does each in constant time:
+;   time ./pl bench/vector.lisp
+
+(defun fill (seq n)
+  (let ((i 1))
+    (while (<= i n)
+      (append i seq)
+      (set i (+ i 1)))
+    seq))
+
+(defun sum-by-index (seq n)
+  (let ((i 1) (acc 0))
+    (while (<= i n)
+      (set acc (+ acc (nth i seq)))
+      (set i (+ i 1)))
+    acc))
+
+(print (sum-by-index (fill (list) 10000) 10000))
+(print (sum-by-index (fill [] 10000) 10000))
@@ -0,0 +1,313 @@
+#include <algorithm>
+#include <cstdio>
+#include <deque>
+#include "bignum.h"
+
+typedef std::vector<uint64_t> Limbs;
+typedef unsigned __int128 uint128_t;
+
+// below this many limbs in the shorter operand schoolbook multiplication is
+// faster than splitting
+static const size_t KARATSUBA_THRESHOLD = 32;
+// 10^19, the largest power of ten that fits in a limb
+static const uint64_t CHUNK = 10000000000000000000ull;
+static const size_t CHUNK_DIGITS = 19;
+// longer literals are split in halves
+static const size_t SPLIT_DIGITS = 1000;
+
+static void trim(Limbs &x) {
+  while (!x.empty() && x.back() == 0) {
+    x.pop_back();
+  }
+}
+
+static size_t significant(const uint64_t *x, size_t n) {
+  while (n > 0 && x[n - 1] == 0) {
+    n--;
+  }
+  return n;
+}
+
+static int compare_magnitude(const Limbs &a, const Limbs &b) {
+  if (a.size() != b.size()) {
+    return a.size() < b.size() ? -1 : 1;
+  }
+  for (size_t i = a.size(); i-- > 0;) {
+    if (a[i] != b[i]) {
+      return a[i] < b[i] ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+// out[offset..] += x, out must be long enough to hold the sum
+static void add_into(Limbs &out, size_t offset, const uint64_t *x, size_t n) {
+  uint64_t carry = 0;
+  size_t i = 0;
+  for (; i < n; i++) {
+    uint128_t sum = (uint128_t)out[offset + i] + x[i] + carry;
+    out[offset + i] = (uint64_t)sum;
+    carry = (uint64_t)(sum >> 64);
+  }
+  for (; carry != 0; i++) {
+    carry = (++out[offset + i] == 0);
+  }
+}
+
+// x -= y, x must be at least y
+static void subtract_from(Limbs &x, const uint64_t *y, size_t n) {
+  uint64_t borrow = 0;
+  size_t i = 0;
+  for (; i < n; i++) {
+    uint128_t difference = (uint128_t)x[i] - y[i] - borrow;
+    x[i] = (uint64_t)difference;
+    borrow = (uint64_t)(difference >> 64) & 1;
+  }
+  for (; borrow != 0; i++) {
+    borrow = (x[i]-- == 0);
+  }
+}
+
+static Limbs add_magnitude(const uint64_t *a, size_t an, const uint64_t *b, size_t bn) {
+  if (an < bn) {
+    std::swap(a, b);
+    std::swap(an, bn);
+  }
+  Limbs out(a, a + an);
+  out.push_back(0);
+  add_into(out, 0, b, bn);
+  trim(out);
+  return out;
+}
+
+// out must hold an + bn zeroed limbs
+static void schoolbook(const uint64_t *a, size_t an, const uint64_t *b, size_t bn, uint64_t *out) {
+  for (size_t i = 0; i < an; i++) {
+    uint64_t carry = 0;
+    for (size_t j = 0; j < bn; j++) {
+      uint128_t t = (uint128_t)a[i] * b[j] + out[i + j] + carry;
+      out[i + j] = (uint64_t)t;
+      carry = (uint64_t)(t >> 64);
+    }
+    out[i + bn] = carry;
+  }
+}
+
+static Limbs multiply(const uint64_t *a, size_t an, const uint64_t *b, size_t bn) {
+  an = significant(a, an);
+  bn = significant(b, bn);
+  if (an < bn) {
+    std::swap(a, b);
+    std::swap(an, bn);
+  }
+  if (bn == 0) {
+    return Limbs{};
+  }
+  Limbs out(an + bn, 0);
+  if (bn < KARATSUBA_THRESHOLD) {
+    schoolbook(a, an, b, bn, out.data());
+  } else if (bn <= an / 2) {
+    // lopsided, splitting a in halves would leave b's top half empty, so
+    // a is taken bn limbs at a time instead
+    for (size_t i = 0; i < an; i += bn) {
+      Limbs part = multiply(a + i, std::min(bn, an - i), b, bn);
+      add_into(out, i, part.data(), part.size());
+    }
+  } else {
+    // a = a1 B^m + a0 and b = b1 B^m + b0, three half size products
+    // instead of four: a1 b1, a0 b0 and (a0 + a1)(b0 + b1)
+    size_t m = an / 2;
+    Limbs low = multiply(a, m, b, m);
+    Limbs high = multiply(a + m, an - m, b + m, bn - m);
+    Limbs a_sum = add_magnitude(a, m, a + m, an - m);
+    Limbs b_sum = add_magnitude(b, m, b + m, bn - m);
+    Limbs middle = multiply(a_sum.data(), a_sum.size(), b_sum.data(), b_sum.size());
+    subtract_from(middle, low.data(), low.size());
+    subtract_from(middle, high.data(), high.size());
+    trim(middle);
+    add_into(out, 0, low.data(), low.size());
+    add_into(out, m, middle.data(), middle.size());
+    add_into(out, 2 * m, high.data(), high.size());
+  }
+  trim(out);
+  return out;
+}
+
+Bignum bignum_from_int(int64_t value) {
+  Bignum b;
+  if (value != 0) {
+    b.negative = value < 0;
+    b.limbs.push_back(b.negative ? 0 - (uint64_t)value : (uint64_t)value);
+  }
+  return b;
+}
+
+bool bignum_to_int(const Bignum &b, int64_t *value) {
+  if (b.limbs.empty()) {
+    *value = 0;
+    return true;
+  }
+  if (b.limbs.size() > 1) {
+    return false;
+  }
+  uint64_t magnitude = b.limbs[0];
+  if (magnitude > (uint64_t)INT64_MAX + b.negative) {
+    return false;
+  }
+  *value = b.negative ? (int64_t)(0 - magnitude) : (int64_t)magnitude;
+  return true;
+}
+
+double bignum_to_double(const Bignum &b) {
+  double d = 0;
+  for (size_t i = b.limbs.size(); i-- > 0;) {
+    d = d * 18446744073709551616.0 + (double)b.limbs[i];
+  }
+  return b.negative ? -d : d;
+}
+
+// a + b with b taken as negative when b_negative is set
+static Bignum add_signed(const Bignum &a, const Bignum &b, bool b_negative) {
+  Bignum r;
+  if (a.negative == b_negative) {
+    r.limbs = add_magnitude(a.limbs.data(), a.limbs.size(), b.limbs.data(), b.limbs.size());
+    r.negative = a.negative;
+  } else if (compare_magnitude(a.limbs, b.limbs) >= 0) {
+    r.limbs = a.limbs;
+    subtract_from(r.limbs, b.limbs.data(), b.limbs.size());
+    r.negative = a.negative;
+  } else {
+    r.limbs = b.limbs;
+    subtract_from(r.limbs, a.limbs.data(), a.limbs.size());
+    r.negative = b_negative;
+  }
+  trim(r.limbs);
+  r.negative = r.negative && !r.limbs.empty();
+  return r;
+}
+
+Bignum bignum_add(const Bignum &a, const Bignum &b) {
+  return add_signed(a, b, b.negative);
+}
+
+Bignum bignum_subtract(const Bignum &a, const Bignum &b) {
+  return add_signed(a, b, !b.negative);
+}
+
+Bignum bignum_multiply(const Bignum &a, const Bignum &b) {
+  Bignum r;
+  r.limbs = multiply(a.limbs.data(), a.limbs.size(), b.limbs.data(), b.limbs.size());
+  r.negative = !r.limbs.empty() && a.negative != b.negative;
+  return r;
+}
+
+int bignum_compare(const Bignum &a, const Bignum &b) {
+  if (a.negative != b.negative) {
+    return a.negative ? -1 : 1;
+  }
+  int c = compare_magnitude(a.limbs, b.limbs);
+  return a.negative ? -c : c;
+}
+
+std::string bignum_to_string(const Bignum &b) {
+  if (b.limbs.empty()) {
+    return "0";
+  }
+  // base 10^19 digits, least significant first
+  Limbs x = b.limbs;
+  std::vector<uint64_t> chunks;
+  while (!x.empty()) {
+    uint64_t remainder = 0;
+    for (size_t i = x.size(); i-- > 0;) {
+      uint128_t cur = ((uint128_t)remainder << 64) | x[i];
+      x[i] = (uint64_t)(cur / CHUNK);
+      remainder = (uint64_t)(cur % CHUNK);
+    }
+    trim(x);
+    chunks.push_back(remainder);
+  }
+  std::string out = b.negative ? "-" : "";
+  out += std::to_string(chunks.back());
+  char buf[CHUNK_DIGITS + 1];
+  for (size_t i = chunks.size() - 1; i-- > 0;) {
+    snprintf(buf, sizeof(buf), "%019llu", (unsigned long long)chunks[i]);
+    out += buf;
+  }
+  return out;
+}
+
+// 10^(19 * 2^k), a deque so references stay good as it grows
+static const Limbs &power_of_ten(size_t k) {
+  static std::deque<Limbs> powers = {Limbs{CHUNK}};
+  while (powers.size() <= k) {
+    const Limbs &p = powers.back();
+    powers.push_back(multiply(p.data(), p.size(), p.data(), p.size()));
+  }
+  return powers[k];
+}
+
+static Limbs parse_magnitude(const char *digits, size_t n) {
+  if (n <= SPLIT_DIGITS) {
+    Limbs x;
+    size_t len = (n % CHUNK_DIGITS == 0) ? CHUNK_DIGITS : n % CHUNK_DIGITS;
+    for (size_t i = 0; i < n; i += len, len = CHUNK_DIGITS) {
+      uint64_t chunk = 0;
+      uint64_t scale = 1;
+      for (size_t j = 0; j < len; j++) {
+	chunk = chunk * 10 + (digits[i + j] - '0');
+	scale *= 10;
+      }
+      // x = x * scale + chunk
+      uint64_t carry = chunk;
+      for (uint64_t &limb : x) {
+	uint128_t t = (uint128_t)limb * scale + carry;
+	limb = (uint64_t)t;
+	carry = (uint64_t)(t >> 64);
+      }
+      if (carry != 0) {
+	x.push_back(carry);
+      }
+    }
+    return x;
+  }
+  // the low part is a power of two number of chunks so the powers of ten
+  // are shared between calls
+  size_t k = 0;
+  while ((CHUNK_DIGITS << (k + 1)) < n) {
+    k++;
+  }
+  size_t low = CHUNK_DIGITS << k;
+  Limbs high = parse_magnitude(digits, n - low);
+  const Limbs &p = power_of_ten(k);
+  Limbs x = multiply(high.data(), high.size(), p.data(), p.size());
+  Limbs rest = parse_magnitude(digits + n - low, low);
+  x.resize(std::max(x.size(), rest.size()) + 1);
+  add_into(x, 0, rest.data(), rest.size());
+  trim(x);
+  return x;
+}
+
+Bignum bignum_from_string(const std::string &digits) {
+  Bignum b;
+  b.limbs = parse_magnitude(digits.data(), digits.size());
+  trim(b.limbs);
+  return b;
+}
+
+Parse_Node *make_bignum(Bignum value) {
+  int64_t small;
+  if (bignum_to_int(value, &small)) {
+    return make_integer(small);
+  }
+  Parse_Node *node = new Parse_Node{PARSE_NODE_LITERAL, LITERAL_BIGNUM};
+  gc_note_external(value.limbs.size() * sizeof(uint64_t));
+  node->val.big = new Bignum(std::move(value));
+  return node;
+}
+
+Bignum to_bignum(Parse_Node *node) {
+  if (node_subtype(node) == LITERAL_BIGNUM) {
+    return bignum_value(node);
+  }
+  return bignum_from_int(integer_value(node));
+}
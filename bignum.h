@@ -0,0 +1,44 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "parser.h"
+
+// Arbitrary precision integers, what integer arithmetic promotes to when a
+// result doesn't fit in 64 bits.
+//
+// A value that fits in 64 bits is never a bignum: make_bignum hands those
+// back as fixnums or boxed integers, so the int64 paths never see one and
+// two equal integers always have the same representation. Products of
+// large operands use Karatsuba multiplication. Decimal conversion goes 19
+// digits at a time, long literals are split in halves and put back
+// together with Karatsuba as well.
+
+struct Bignum {
+  std::vector<uint64_t> limbs;  // magnitude, least significant first, no leading zeros
+  bool negative = false;  // never set for zero
+};
+
+Bignum bignum_from_int(int64_t value);
+// false if b doesn't fit in 64 bits
+bool bignum_to_int(const Bignum &b, int64_t *value);
+double bignum_to_double(const Bignum &b);
+
+Bignum bignum_add(const Bignum &a, const Bignum &b);
+Bignum bignum_subtract(const Bignum &a, const Bignum &b);
+Bignum bignum_multiply(const Bignum &a, const Bignum &b);
+// negative, zero or positive as a is less than, equal to or greater than b
+int bignum_compare(const Bignum &a, const Bignum &b);
+
+std::string bignum_to_string(const Bignum &b);
+// digits is a non-empty string of decimal digits
+Bignum bignum_from_string(const std::string &digits);
+
+// a fixnum or boxed integer if value fits in 64 bits, a LITERAL_BIGNUM
+// otherwise
+Parse_Node *make_bignum(Bignum value);
+// node must be an integer or a bignum
+Bignum to_bignum(Parse_Node *node);
+
+inline const Bignum &bignum_value(Parse_Node *node) {
+  return *node->val.big;
+}
@@ -0,0 +1,318 @@
+#include "builtin_array.h"
+#include "builtin_helpers.h"
+#include "builtin_logic.h"
+#include "array_kernels.h"
+#include "gc.h"
+#include "bignum.h"
+
+static Parse_Node *make_int_array(size_t size, int64_t init = 0) {
+  Parse_Node *array = new Parse_Node{PARSE_NODE_ARRAY, ARRAY_INT64};
+  array->val.ints = new std::vector<int64_t>(size, init);
+  gc_note_external(size * sizeof(int64_t));
+  return array;
+}
+
+static Parse_Node *make_float_array(size_t size, double init = 0) {
+  Parse_Node *array = new Parse_Node{PARSE_NODE_ARRAY, ARRAY_FLOAT64};
+  array->val.floats = new std::vector<double>(size, init);
+  gc_note_external(size * sizeof(double));
+  return array;
+}
+
+static bool is_int_array(Parse_Node *array) {
+  return array->subtype == ARRAY_INT64;
+}
+
+static const char *kind_name(Parse_Node *array) {
+  return is_int_array(array) ? "an int-array" : "a float-array";
+}
+
+size_t array_length(Parse_Node *array) {
+  return is_int_array(array) ? array->val.ints->size() : array->val.floats->size();
+}
+
+Parse_Node *array_element(Parse_Node *array, size_t index) {
+  if (is_int_array(array)) {
+    return make_integer((*array->val.ints)[index]);
+  }
+  return make_float((*array->val.floats)[index]);
+}
+
+static int64_t integer_arg(const char *name, Parse_Node *value) {
+  if (is_bignum(value)) {
+    throw runtimeError(std::string("Error: ") + name + " was given " + print_node(value) +
+		       ", which doesn't fit in 64 bits\n");
+  }
+  if (!is_integer(value)) {
+    throw runtimeError(std::string("Error: ") + name + " was given " + print_node(value) +
+		       ", which is not an integer\n");
+  }
+  return integer_value(value);
+}
+
+static double number_arg(const char *name, Parse_Node *value) {
+  if (!is_number(value)) {
+    throw runtimeError(std::string("Error: ") + name + " was given " + print_node(value) +
+		       ", which is not a number\n");
+  }
+  if (is_bignum(value)) {
+    return bignum_to_double(bignum_value(value));
+  }
+  return is_integer(value) ? (double)integer_value(value) : value->val.dub;
+}
+
+void set_array_element(Parse_Node *array, size_t index, Parse_Node *value) {
+  if (is_int_array(array)) {
+    (*array->val.ints)[index] = integer_arg("set", value);
+  } else {
+    (*array->val.floats)[index] = number_arg("set", value);
+  }
+}
+
+static Parse_Node *array_arg(const char *name, Parse_Node *value) {
+  if (!is_array(value)) {
+    throw runtimeError(std::string("Error: ") + name + " was given " + print_node(value) +
+		       ", which is not an array\n");
+  }
+  return value;
+}
+
+// both arrays, of the same kind and length
+static void check_pair(const char *name, Parse_Node *a, Parse_Node *b) {
+  array_arg(name, a);
+  array_arg(name, b);
+  if (a->subtype != b->subtype) {
+    throw runtimeError(std::string("Error: ") + name + " was given " + kind_name(a) +
+		       " and " + kind_name(b) + "\n");
+  }
+  if (array_length(a) != array_length(b)) {
+    throw runtimeError(std::string("Error: ") + name + " was given arrays of length " +
+		       std::to_string(array_length(a)) + " and " +
+		       std::to_string(array_length(b)) + "\n");
+  }
+}
+
+static void check_int_array(const char *name, Parse_Node *array) {
+  if (!is_int_array(array)) {
+    throw runtimeError(std::string("Error: ") + name + " only works on int-arrays\n");
+  }
+}
+
+// the sum of x when it doesn't fit in 64 bits
+static Parse_Node *big_sum(const std::vector<int64_t> &x) {
+  Bignum acc;
+  for (int64_t value : x) {
+    acc = bignum_add(acc, bignum_from_int(value));
+  }
+  return make_bignum(std::move(acc));
+}
+
+[[noreturn]] static void throw_overflow(const char *name) {
+  throw runtimeError(std::string("Error: integer overflow in ") + name + "\n");
+}
+
+static size_t size_arg(const char *name, Parse_Node *value) {
+  int64_t size = integer_arg(name, value);
+  if (size < 0) {
+    throw runtimeError(std::string("Error: ") + name + " was given a negative size\n");
+  }
+  return size;
+}
+
+Parse_Node *builtin_int_array(Parse_Node **args, uint32_t argc) {
+  Parse_Node *array = make_int_array(argc);
+  for (uint32_t i = 0; i < argc; i++) {
+    (*array->val.ints)[i] = integer_arg("int-array", args[i]);
+  }
+  return array;
+}
+
+Parse_Node *builtin_float_array(Parse_Node **args, uint32_t argc) {
+  Parse_Node *array = make_float_array(argc);
+  for (uint32_t i = 0; i < argc; i++) {
+    (*array->val.floats)[i] = number_arg("float-array", args[i]);
+  }
+  return array;
+}
+
+// (make-int-array size [init])
+Parse_Node *builtin_make_int_array(Parse_Node **args, uint32_t argc) {
+  size_t size = size_arg("make-int-array", args[0]);
+  return make_int_array(size, argc == 2 ? integer_arg("make-int-array", args[1]) : 0);
+}
+
+// (make-float-array size [init])
+Parse_Node *builtin_make_float_array(Parse_Node **args, uint32_t argc) {
+  size_t size = size_arg("make-float-array", args[0]);
+  return make_float_array(size, argc == 2 ? number_arg("make-float-array", args[1]) : 0);
+}
+
+// integer sums are exact, a total that doesn't fit in 64 bits is a bignum
+Parse_Node *builtin_array_sum(Parse_Node **args, uint32_t argc) {
+  Parse_Node *a = array_arg("array-sum", args[0]);
+  if (is_int_array(a)) {
+    int64_t sum;
+    if (!array_kernels->sum_int(a->val.ints->data(), a->val.ints->size(), &sum)) {
+      return big_sum(*a->val.ints);
+    }
+    return make_integer(sum);
+  }
+  return make_float(array_kernels->sum_float(a->val.floats->data(), a->val.floats->size()));
+}
+
+Parse_Node *builtin_array_min(Parse_Node **args, uint32_t argc) {
+  Parse_Node *a = array_arg("array-min", args[0]);
+  if (array_length(a) == 0) {
+    throw runtimeError("Error: array-min was given an empty array\n");
+  }
+  if (is_int_array(a)) {
+    return make_integer(array_kernels->min_int(a->val.ints->data(), a->val.ints->size()));
+  }
+  return make_float(array_kernels->min_float(a->val.floats->data(), a->val.floats->size()));
+}
+
+Parse_Node *builtin_array_max(Parse_Node **args, uint32_t argc) {
+  Parse_Node *a = array_arg("array-max", args[0]);
+  if (array_length(a) == 0) {
+    throw runtimeError("Error: array-max was given an empty array\n");
+  }
+  if (is_int_array(a)) {
+    return make_integer(array_kernels->max_int(a->val.ints->data(), a->val.ints->size()));
+  }
+  return make_float(array_kernels->max_float(a->val.floats->data(), a->val.floats->size()));
+}
+
+Parse_Node *builtin_array_dot(Parse_Node **args, uint32_t argc) {
+  Parse_Node *a = args[0];
+  Parse_Node *b = args[1];
+  check_pair("array-dot", a, b);
+  if (is_int_array(a)) {
+    std::vector<int64_t> &x = *a->val.ints;
+    std::vector<int64_t> &y = *b->val.ints;
+    int64_t acc = 0;
+    for (size_t i = 0; i < x.size(); i++) {
+      int64_t product;
+      if (__builtin_mul_overflow(x[i], y[i], &product) ||
+	  __builtin_add_overflow(acc, product, &acc)) {
+	// carry on from the start with bignums
+	Bignum big;
+	for (size_t j = 0; j < x.size(); j++) {
+	  big = bignum_add(big, bignum_multiply(bignum_from_int(x[j]), bignum_from_int(y[j])));
+	}
+	return make_bignum(std::move(big));
+      }
+    }
+    return make_integer(acc);
+  }
+  return make_float(array_kernels->dot_float(a->val.floats->data(), b->val.floats->data(),
+					     a->val.floats->size()));
+}
+
+// (array-scale array factor), an int-array takes an integer factor
+Parse_Node *builtin_array_scale(Parse_Node **args, uint32_t argc) {
+  Parse_Node *a = array_arg("array-scale", args[0]);
+  size_t n = array_length(a);
+  if (is_int_array(a)) {
+    int64_t k = integer_arg("array-scale", args[1]);
+    Parse_Node *out = make_int_array(n);
+    std::vector<int64_t> &x = *a->val.ints;
+    std::vector<int64_t> &y = *out->val.ints;
+    for (size_t i = 0; i < n; i++) {
+      if (__builtin_mul_overflow(x[i], k, &y[i])) {
+	throw_overflow("array-scale");
+      }
+    }
+    return out;
+  }
+  double k = number_arg("array-scale", args[1]);
+  Parse_Node *out = make_float_array(n);
+  array_kernels->scale_float(a->val.floats->data(), k, out->val.floats->data(), n);
+  return out;
+}
+
+Parse_Node *builtin_array_add(Parse_Node **args, uint32_t argc) {
+  Parse_Node *a = args[0];
+  Parse_Node *b = args[1];
+  check_pair("array-add", a, b);
+  size_t n = array_length(a);
+  if (is_int_array(a)) {
+    Parse_Node *out = make_int_array(n);
+    if (!array_kernels->add_int(a->val.ints->data(), b->val.ints->data(), out->val.ints->data(), n)) {
+      throw_overflow("array-add");
+    }
+    return out;
+  }
+  Parse_Node *out = make_float_array(n);
+  array_kernels->add_float(a->val.floats->data(), b->val.floats->data(), out->val.floats->data(), n);
+  return out;
+}
+
+Parse_Node *builtin_array_mul(Parse_Node **args, uint32_t argc) {
+  Parse_Node *a = args[0];
+  Parse_Node *b = args[1];
+  check_pair("array-mul", a, b);
+  size_t n = array_length(a);
+  if (is_int_array(a)) {
+    Parse_Node *out = make_int_array(n);
+    std::vector<int64_t> &x = *a->val.ints;
+    std::vector<int64_t> &y = *b->val.ints;
+    std::vector<int64_t> &z = *out->val.ints;
+    for (size_t i = 0; i < n; i++) {
+      if (__builtin_mul_overflow(x[i], y[i], &z[i])) {
+	throw_overflow("array-mul");
+      }
+    }
+    return out;
+  }
+  Parse_Node *out = make_float_array(n);
+  array_kernels->mul_float(a->val.floats->data(), b->val.floats->data(), out->val.floats->data(), n);
+  return out;
+}
+
+static Parse_Node *bitwise(const char *name, Parse_Node **args,
+			   void (*kernel)(const int64_t *, const int64_t *, int64_t *, size_t)) {
+  Parse_Node *a = args[0];
+  Parse_Node *b = args[1];
+  check_pair(name, a, b);
+  check_int_array(name, a);
+  size_t n = array_length(a);
+  Parse_Node *out = make_int_array(n);
+  kernel(a->val.ints->data(), b->val.ints->data(), out->val.ints->data(), n);
+  return out;
+}
+
+Parse_Node *builtin_array_and(Parse_Node **args, uint32_t argc) {
+  return bitwise("array-and", args, array_kernels->and_int);
+}
+
+Parse_Node *builtin_array_or(Parse_Node **args, uint32_t argc) {
+  return bitwise("array-or", args, array_kernels->or_int);
+}
+
+Parse_Node *builtin_array_xor(Parse_Node **args, uint32_t argc) {
+  return bitwise("array-xor", args, array_kernels->xor_int);
+}
+
+// (array-shl array count), count defaults to 1 like <<
+static Parse_Node *shift(const char *name, Parse_Node **args, uint32_t argc,
+			 void (*kernel)(const int64_t *, unsigned, int64_t *, size_t)) {
+  Parse_Node *a = array_arg(name, args[0]);
+  check_int_array(name, a);
+  int64_t count = argc == 2 ? integer_arg(name, args[1]) : 1;
+  if (count < 0 || count > 63) {
+    throw runtimeError(std::string("Error: ") + name + " shift count " + std::to_string(count) +
+		       " is not between 0 and 63\n");
+  }
+  size_t n = array_length(a);
+  Parse_Node *out = make_int_array(n);
+  kernel(a->val.ints->data(), count, out->val.ints->data(), n);
+  return out;
+}
+
+Parse_Node *builtin_array_shift_left(Parse_Node **args, uint32_t argc) {
+  return shift("array-shl", args, argc, array_kernels->shift_left);
+}
+
+Parse_Node *builtin_array_shift_right(Parse_Node **args, uint32_t argc) {
+  return shift("array-shr", args, argc, array_kernels->shift_right);
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "parser.h"
+#include "interp.h"
+
+// Packed arrays hold int64 or double elements unboxed in one block, the
+// collector never looks inside them. The array-* builtins run over them
+// with the kernels in array_kernels.h. Elementwise builtins return a new
+// array, the two arrays must have the same kind and length.
+
+size_t array_length(Parse_Node *array);
+// index must be in range
+Parse_Node *array_element(Parse_Node *array, size_t index);
+void set_array_element(Parse_Node *array, size_t index, Parse_Node *value);
+
+Parse_Node *builtin_int_array(Parse_Node **args, uint32_t argc);
+Parse_Node *builtin_float_array(Parse_Node **args, uint32_t argc);
+Parse_Node *builtin_make_int_array(Parse_Node **args, uint32_t argc);
+Parse_Node *builtin_make_float_array(Parse_Node **args, uint32_t argc);
+Parse_Node *builtin_array_sum(Parse_Node **args, uint32_t argc);
+Parse_Node *builtin_array_min(Parse_Node **args, uint32_t argc);
+Parse_Node *builtin_array_max(Parse_Node **args, uint32_t argc);
+Parse_Node *builtin_array_dot(Parse_Node **args, uint32_t argc);
+Parse_Node *builtin_array_scale(Parse_Node **args, uint32_t argc);
+Parse_Node *builtin_array_add(Parse_Node **args, uint32_t argc);
+Parse_Node *builtin_array_mul(Parse_Node **args, uint32_t argc);
+Parse_Node *builtin_array_and(Parse_Node **args, uint32_t argc);
+Parse_Node *builtin_array_or(Parse_Node **args, uint32_t argc);
+Parse_Node *builtin_array_xor(Parse_Node **args, uint32_t argc);
+Parse_Node *builtin_array_shift_left(Parse_Node **args, uint32_t argc);
+Parse_Node *builtin_array_shift_right(Parse_Node **args, uint32_t argc);
@@ -0,0 +1,98 @@
+#include "builtin_hash.h"
+#include "builtin_helpers.h"
+#include "builtin_logic.h"
+#include "hash_table.h"
+
+bool is_hash(Parse_Node *node) {
+  return (node_type(node) == PARSE_NODE_HASH);
+}
+
+static Hash_Table *check_hash(const char *name, Parse_Node *node) {
+  if (!is_hash(node)) {
+    throw runtimeError(std::string("Error: ") + name + " was given " + print_node(node) +
+		       ", which is not a hash table\n");
+  }
+  return node->val.hash;
+}
+
+static Parse_Node *check_key(const char *name, Parse_Node *key) {
+  if (!is_hash_key(key)) {
+    throw runtimeError(std::string("Error: ") + name + " was given the key " + print_node(key) +
+		       ", keys are integers, strings, symbols and keywords\n");
+  }
+  return key;
+}
+
+Parse_Node *builtin_make_hash(Parse_Node **args, uint32_t argc) {
+  Parse_Node *table = new Parse_Node{PARSE_NODE_HASH};
+  table->val.hash = new Hash_Table();
+  return table;
+}
+
+// (hash-get table key [default]), default is the empty list
+Parse_Node *builtin_hash_get(Parse_Node **args, uint32_t argc) {
+  Hash_Table *table = check_hash("hash-get", args[0]);
+  Parse_Node *value = table->get(check_key("hash-get", args[1]));
+  if (value != nullptr) {
+    return value;
+  }
+  return argc == 3 ? args[2] : new Parse_Node{PARSE_NODE_LIST};
+}
+
+// (hash-set table key value), returns value
+Parse_Node *builtin_hash_set(Parse_Node **args, uint32_t argc) {
+  Hash_Table *table = check_hash("hash-set", args[0]);
+  table->set(check_key("hash-set", args[1]), args[2]);
+  return args[2];
+}
+
+// (hash-remove table key), whether key was there
+Parse_Node *builtin_hash_remove(Parse_Node **args, uint32_t argc) {
+  Hash_Table *table = check_hash("hash-remove", args[0]);
+  return table->remove(check_key("hash-remove", args[1])) ? tru : fal;
+}
+
+Parse_Node *builtin_hash_count(Parse_Node **args, uint32_t argc) {
+  return make_integer(check_hash("hash-count", args[0])->size());
+}
+
+// (hash-for-each (key value table) body...), visits the entries the table
+// held when it started, the body is free to change the table
+Parse_Node *builtin_hash_for_each(Parse_Node *args, Symbol_Table *env) {
+  ARG_COUNT_MIN("hash-for-each", 1);
+
+  Parse_Node *binding = args->first;
+  if (!is_list(binding) || binding->length() != 3 ||
+      !is_sym(binding->first) || !is_sym(binding->next->first)) {
+    throw runtimeError("Error: hash-for-each binding must be (key value table)\n");
+  }
+
+  Parse_Node *table = eval_parse_node(binding->next->next->first, env);
+  if (is_return(table)) {
+    return table;
+  }
+  Hash_Table *hash = check_hash("hash-for-each", table);
+
+  // a vector so the collector keeps removed entries alive until they're visited
+  Parse_Node *snapshot = make_vector();
+  std::vector<Parse_Node *> &entries = vector_value(snapshot);
+  entries.reserve(hash->size() * 2);
+  hash->for_each([&entries](Parse_Node *key, Parse_Node *value) {
+    entries.push_back(key);
+    entries.push_back(value);
+  });
+
+  Symbol_Table *frame = new Symbol_Table(env);
+  Parse_Node *ret = new Parse_Node{PARSE_NODE_LIST};
+  for (size_t i = 0; i < entries.size(); i += 2) {
+    frame->define(binding->first->aux, entries[i]);
+    frame->define(binding->next->first->aux, entries[i + 1]);
+    for (Parse_Node *body = args->next; body->first != nullptr; body = body->next) {
+      ret = eval_parse_node(body->first, frame);
+      if (is_return(ret)) {
+	return ret;
+      }
+    }
+  }
+  return ret;
+}
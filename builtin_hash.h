@@ -0,0 +1,12 @@
+#pragma once
+#include "parser.h"
+#include "interp.h"
+
+bool is_hash(Parse_Node *node);
+
+Parse_Node *builtin_make_hash(Parse_Node **args, uint32_t argc);
+Parse_Node *builtin_hash_get(Parse_Node **args, uint32_t argc);
+Parse_Node *builtin_hash_set(Parse_Node **args, uint32_t argc);
+Parse_Node *builtin_hash_remove(Parse_Node **args, uint32_t argc);
+Parse_Node *builtin_hash_count(Parse_Node **args, uint32_t argc);
+Parse_Node *builtin_hash_for_each(Parse_Node *args, Symbol_Table *env);
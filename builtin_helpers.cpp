@@ -1,41 +1,53 @@
 #include "builtin_helpers.h"
 
 bool is_integer(Parse_Node *node) {
-  return (node->subtype == LITERAL_INTEGER);
+  return (node_subtype(node) == LITERAL_INTEGER);
+}
+
+bool is_bignum(Parse_Node *node) {
+  return (node_subtype(node) == LITERAL_BIGNUM);
 }
 
 bool is_float(Parse_Node *node) {
-  return (node->subtype == LITERAL_FLOAT);
+  return (node_subtype(node) == LITERAL_FLOAT);
 }
 
 bool is_string(Parse_Node *node) {
-  if (node->type != PARSE_NODE_LITERAL) {
+  if (node_type(node) != PARSE_NODE_LITERAL) {
     return false;
   }
-  return (node->subtype == LITERAL_STRING);
+  return (node_subtype(node) == LITERAL_STRING);
 }
 
 bool is_list(Parse_Node *node) {
-  return (node->type == PARSE_NODE_LIST);
+  return (node_type(node) == PARSE_NODE_LIST);
+}
+
+bool is_vector(Parse_Node *node) {
+  return (node_type(node) == PARSE_NODE_VECTOR);
+}
+
+bool is_array(Parse_Node *node) {
+  return (node_type(node) == PARSE_NODE_ARRAY);
 }
 
 bool is_sym(Parse_Node *node) {
-  return (node->type == PARSE_NODE_SYMBOL);
+  return (node_type(node) == PARSE_NODE_SYMBOL);
 }
 
 bool is_keyword(Parse_Node *node) {
-  return (node->subtype == SYMBOL_KEYWORD);
+  return (node_subtype(node) == SYMBOL_KEYWORD);
 }
 
 //assumes that node is a list
 bool is_empty_list(Parse_Node *node) {
-  return (node->first == nullptr);
+  return (is_fixnum(node) || node->first == nullptr);
 }
 
 bool is_sequence(Parse_Node *node) {
-  return is_list(node) || is_string(node);
+  return is_list(node) || is_vector(node) || is_array(node) || is_string(node);
 }
 
 bool is_error(Parse_Node *node) {
-  return (node->type == PARSE_NODE_ERROR);
+  return (node_type(node) == PARSE_NODE_ERROR);
 }
@@ -10,12 +10,19 @@
 
 bool is_integer(Parse_Node *node);
 
+// integers that don't fit in 64 bits, see bignum.h
+bool is_bignum(Parse_Node *node);
+
 bool is_float(Parse_Node *node);
 
 bool is_string(Parse_Node *node);
 
 bool is_list(Parse_Node *node);
 
+bool is_vector(Parse_Node *node);
+
+bool is_array(Parse_Node *node);
+
 bool is_sym(Parse_Node *node);
 
 bool is_keyword(Parse_Node *node);
@@ -4,11 +4,12 @@ Parse_Node *tru;
 Parse_Node *fal;
 
 bool is_number(Parse_Node *node) {
-  return (node->subtype == LITERAL_INTEGER || node->subtype == LITERAL_FLOAT);
+  Parse_Node_Subtype subtype = node_subtype(node);
+  return (subtype == LITERAL_INTEGER || subtype == LITERAL_FLOAT || subtype == LITERAL_BIGNUM);
 }
 
 bool is_bool(Parse_Node *node) {
-  return (node->subtype == LITERAL_BOOLEAN);
+  return (node_subtype(node) == LITERAL_BOOLEAN);
 }
 
 bool bool_value(Parse_Node *node) {
@@ -21,6 +22,9 @@ bool bool_value(Parse_Node *node) {
 Parse_Node *builtin_and(Parse_Node *args, Symbol_Table *env) {
   while(args->first != nullptr) {
     Parse_Node *earg = eval_parse_node(args->first, env);
+    if (is_return(earg)) {
+      return earg;
+    }
     bool val = bool_value(earg);
     if (val == false) {
       return fal;
@@ -33,6 +37,9 @@ Parse_Node *builtin_and(Parse_Node *args, Symbol_Table *env) {
 Parse_Node *builtin_or(Parse_Node *args, Symbol_Table *env) {
   while(args->first != nullptr) {
     Parse_Node *earg = eval_parse_node(args->first, env);
+    if (is_return(earg)) {
+      return earg;
+    }
     bool val = bool_value(earg);
     if (val) {
       return tru;
@@ -42,12 +49,8 @@ Parse_Node *builtin_or(Parse_Node *args, Symbol_Table *env) {
   return fal;
 }
 
-Parse_Node *builtin_not(Parse_Node *args, Symbol_Table *env) {
-  if (args->length() != 1) {
-    fprintf(stderr, "Error: not takes exactly 1 argument\n");
-  }
-  Parse_Node *earg = eval_parse_node(args->first, env);
-  bool val = bool_value(earg);
+Parse_Node *builtin_not(Parse_Node **args, uint32_t argc) {
+  bool val = bool_value(args[0]);
   if (val) {
     return fal;
   }
@@ -11,4 +11,4 @@ bool bool_value(Parse_Node *node);
 
 Parse_Node *builtin_and(Parse_Node *args, Symbol_Table *env);
 Parse_Node *builtin_or(Parse_Node *args, Symbol_Table *env);
-Parse_Node *builtin_not(Parse_Node *args, Symbol_Table *env);
+Parse_Node *builtin_not(Parse_Node **args, uint32_t argc);
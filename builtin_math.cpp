@@ -1,560 +1,318 @@
 #include "builtin_helpers.h"
 #include "builtin_math.h"
 #include "builtin_logic.h"
+#include "bignum.h"
 
-Parse_Node *builtin_add(Parse_Node *args, Symbol_Table *env) {
-  int64_t sum = 0;
-  double fsum = 0;
+// Numeric builtins dispatch on the operand types once per argument and run
+// a kernel specialized for them: integers go through checked int64
+// arithmetic, anything with a float in it through doubles. An integer
+// result that doesn't fit in 64 bits carries on as a bignum, see bignum.h.
 
-  Parse_Node *cur = args;
-  while (cur->first != nullptr) {
-    Parse_Node *arg = eval_parse_node(cur->first, env);
-    if (arg->type != PARSE_NODE_LITERAL) {
-      fprintf(stderr, "+ was given non literal to add\n");
-      return nullptr;
-    }
-    
-    if (arg->subtype == LITERAL_FLOAT) {
-      fsum += arg->val.dub;
-    } else if (arg->subtype == LITERAL_INTEGER) {
-      sum += arg->val.u64;
-    } else {
-      fprintf(stderr, "argument not a number\n");
-      return nullptr;
-    }
-    cur = cur->next;
-  }
-  
-  Parse_Node *s = new Parse_Node{PARSE_NODE_LITERAL};
-  if (fsum != 0.0) {
-    s->subtype = LITERAL_FLOAT;
-    s->val.dub = fsum + sum;
-  } else {
-    s->subtype = LITERAL_INTEGER;
-    s->val.u64 = sum;
+static double as_double(Parse_Node *number) {
+  if (is_bignum(number)) {
+    return bignum_to_double(bignum_value(number));
   }
-  return s;
+  return is_integer(number) ? (double)integer_value(number) : number->val.dub;
 }
 
-Parse_Node *builtin_subtract(Parse_Node *args, Symbol_Table *env) {
-  int64_t start = 0;
-  double fstart = 0;
-  int64_t sum = 0;
-  double fsum = 0;
-  bool first_is_int = true;
-  bool rest_are_int = true;
-
-  Parse_Node *cur = args;
-  if (is_empty_list(cur)) {
-    throw runtimeError("Error: - takes one or more argument\n");
+// returns arg if it's an error value, which becomes the result, nullptr if
+// it's a number and throws otherwise
+static Parse_Node *check_number(const char *name, Parse_Node *arg) {
+  if (is_error(arg)) {
+    return arg;
   }
-
-  Parse_Node *arg = eval_parse_node(cur->first, env);
-  if (is_integer(arg)) {
-    start = arg->val.u64;
-  } else if (is_float(arg)) {
-    fstart = arg->val.dub;
-  } else {
-    throw runtimeError("Error: - was given non-number argument " + cur->first->print() + "\n");
+  if (!is_number(arg)) {
+    throw runtimeError(std::string("Error: ") + name + " was given non-number argument " +
+		       print_node(arg) + "\n");
   }
+  return nullptr;
+}
 
-  cur = cur->next;
-
-  while (!is_empty_list(cur)) {
-    Parse_Node *arg = eval_parse_node(cur->first, env);
-    if (is_float(arg)) {
-      rest_are_int = false;
-      fsum += arg->val.dub;
-    } else if (is_integer(arg)) {
-      sum += arg->val.u64;
-    } else {
-      throw runtimeError("Error: - was given non-number argument "  + cur->first->print() + "\n");
+struct Add {
+  static constexpr const char *name = "+";
+  static bool overflows(int64_t a, int64_t b, int64_t *result) { return __builtin_add_overflow(a, b, result); }
+  static double apply(double a, double b) { return a + b; }
+  static Bignum big(const Bignum &a, const Bignum &b) { return bignum_add(a, b); }
+};
+
+struct Subtract {
+  static constexpr const char *name = "-";
+  static bool overflows(int64_t a, int64_t b, int64_t *result) { return __builtin_sub_overflow(a, b, result); }
+  static double apply(double a, double b) { return a - b; }
+  static Bignum big(const Bignum &a, const Bignum &b) { return bignum_subtract(a, b); }
+};
+
+struct Multiply {
+  static constexpr const char *name = "*";
+  static bool overflows(int64_t a, int64_t b, int64_t *result) { return __builtin_mul_overflow(a, b, result); }
+  static double apply(double a, double b) { return a * b; }
+  static Bignum big(const Bignum &a, const Bignum &b) { return bignum_multiply(a, b); }
+};
+
+// folds args[from..] into acc with doubles
+template <typename Op>
+static Parse_Node *real_arithmetic(Parse_Node **args, uint32_t argc, uint32_t from, double acc) {
+  for (uint32_t i = from; i < argc; i++) {
+    Parse_Node *error = check_number(Op::name, args[i]);
+    if (error != nullptr) {
+      return error;
     }
-    cur = cur->next;
+    acc = Op::apply(acc, as_double(args[i]));
   }
-  
-  Parse_Node *ret = new Parse_Node{PARSE_NODE_LITERAL};
-  if (first_is_int) {
-    if (rest_are_int) {
-      ret->subtype = LITERAL_INTEGER;
-      ret->val.u64 = start - sum;
+  return make_float(acc);
+}
+
+// folds args[from..] into acc with bignums
+template <typename Op>
+static Parse_Node *big_arithmetic(Parse_Node **args, uint32_t argc, uint32_t from, Bignum acc) {
+  for (uint32_t i = from; i < argc; i++) {
+    Parse_Node *arg = args[i];
+    if (is_bignum(arg)) {
+      acc = Op::big(acc, bignum_value(arg));
+    } else if (is_integer(arg)) {
+      acc = Op::big(acc, bignum_from_int(integer_value(arg)));
     } else {
-      ret->subtype = LITERAL_FLOAT;
-      ret->val.dub = start - (sum + fsum);
+      return real_arithmetic<Op>(args, argc, i, bignum_to_double(acc));
     }
-  } else {
-    ret->subtype = LITERAL_FLOAT;
-    ret->val.dub = fstart - (sum + fsum);
   }
-  
-  return ret;
+  return make_bignum(std::move(acc));
 }
 
-Parse_Node *builtin_multiply(Parse_Node *args, Symbol_Table *env) {
-  int64_t prod = 1;
-  double fprod = 1;
-  bool is_float = false;
-
-  Parse_Node *cur = args;
-  while (cur->first != nullptr) {
-    Parse_Node *arg = eval_parse_node(cur->first, env);
-    
-    if (arg->subtype == LITERAL_FLOAT) {
-      fprod *= arg->val.dub;
-    } else if (arg->subtype == LITERAL_INTEGER) {
-      prod *= arg->val.u64;
+// folds args[from..] into acc left to right, staying on int64 until the
+// first argument that isn't one or the first result that doesn't fit
+template <typename Op>
+static Parse_Node *arithmetic(Parse_Node **args, uint32_t argc, uint32_t from, int64_t acc) {
+  uint32_t i = from;
+  for (; i < argc; i++) {
+    Parse_Node *arg = args[i];
+    int64_t value;
+    if (is_fixnum(arg)) {
+      value = fixnum_value(arg);
+    } else if (is_integer(arg)) {
+      value = integer_value(arg);
+    } else if (is_bignum(arg)) {
+      return big_arithmetic<Op>(args, argc, i, bignum_from_int(acc));
     } else {
-      fprintf(stderr, "* was given non number to multiply\n");
+      return real_arithmetic<Op>(args, argc, i, (double)acc);
+    }
+    int64_t result;
+    if (Op::overflows(acc, value, &result)) {
+      return big_arithmetic<Op>(args, argc, i, bignum_from_int(acc));
     }
-    cur = cur->next;
+    acc = result;
   }
+  return make_integer(acc);
+}
 
-  Parse_Node *s = new Parse_Node{PARSE_NODE_LITERAL};
-  if (fprod != 1) {
-    s->subtype = LITERAL_FLOAT;
-    s->val.dub = fprod * prod;
-  } else {
-    s->subtype = LITERAL_INTEGER;
-    s->val.u64 = prod;
-  }
-  return s;
+Parse_Node *builtin_add(Parse_Node **args, uint32_t argc) {
+  return arithmetic<Add>(args, argc, 0, 0);
 }
 
-Parse_Node *builtin_greater_than_equal(Parse_Node *args, Symbol_Table *env) {
-  if (args->first == nullptr) {
-    fprintf(stderr,"Error: not enough arguments\n");
-    return nullptr;
+Parse_Node *builtin_subtract(Parse_Node **args, uint32_t argc) {
+  Parse_Node *first = args[0];
+  if (is_integer(first)) {
+    return arithmetic<Subtract>(args, argc, 1, integer_value(first));
   }
-  Parse_Node *prev = eval_parse_node(args->first, env);
-  bool prev_int = (prev->subtype == LITERAL_INTEGER);
-  
-  if (!is_number(prev)) {
-    fprintf(stderr, "Error: argument 1, %s, is not a number\n",
-	    prev->print().c_str());
-    return nullptr;
+  if (is_bignum(first)) {
+    return big_arithmetic<Subtract>(args, argc, 1, bignum_value(first));
   }
-  Parse_Node *cur = args->next;
-  while (cur->first != nullptr) {
-    Parse_Node *ecur = eval_parse_node(cur->first, env);
-    if (!is_number(ecur)) {
-      fprintf(stderr, "Error: argument %s, is not a number",
-	      cur->first->print().c_str());
-      return nullptr;      
-    }
-    bool cur_int = (ecur->subtype == LITERAL_INTEGER);
-    if (prev_int) {
-      if (cur_int) {
-	if (! (prev->val.u64 >= ecur->val.u64)) {return fal;}
-      } else {
-	if (! (prev->val.u64 >= ecur->val.dub)) {return fal;}
-      }
-    } else {
-      if (cur_int) {
-	if (! (prev->val.dub >= ecur->val.u64)) {return fal;}
-      } else {
-	if (! (prev->val.dub >= ecur->val.dub)) {return fal;}
-      }
-    }    
-    prev = ecur;
-    prev_int = cur_int;
-    cur = cur->next;
+  Parse_Node *error = check_number("-", first);
+  if (error != nullptr) {
+    return error;
   }
-  return tru;
+  return real_arithmetic<Subtract>(args, argc, 1, first->val.dub);
 }
 
-Parse_Node *builtin_greater_than(Parse_Node *args, Symbol_Table *env) {
-  if (args->first == nullptr) {
-    fprintf(stderr,"Error: not enough arguments\n");
-    return nullptr;
-  }
-  Parse_Node *prev = eval_parse_node(args->first, env);
-  bool prev_int = (prev->subtype == LITERAL_INTEGER);
-  
-  if (!is_number(prev)) {
-    fprintf(stderr, "Error: argument 1, %s, is not a number\n",
-	    prev->print().c_str());
-    return nullptr;
-  }
-  Parse_Node *cur = args->next;
-  while (cur->first != nullptr) {
-    Parse_Node *ecur = eval_parse_node(cur->first, env);
-    if (!is_number(ecur)) {
-      fprintf(stderr, "Error: argument %s, is not a number",
-	      cur->first->print().c_str());
-      return nullptr;      
-    }
-    bool cur_int = (ecur->subtype == LITERAL_INTEGER);
-    if (prev_int) {
-      if (cur_int) {
-	if (! (prev->val.u64 > ecur->val.u64)) {return fal;}
-      } else {
-	if (! (prev->val.u64 > ecur->val.dub)) {return fal;}
-      }
-    } else {
-      if (cur_int) {
-	if (! (prev->val.dub > ecur->val.u64)) {return fal;}
-      } else {
-	if (! (prev->val.dub > ecur->val.dub)) {return fal;}
-      }
-    }    
-    prev = ecur;
-    prev_int = cur_int;
-    cur = cur->next;
-  }
-  return tru;
+Parse_Node *builtin_multiply(Parse_Node **args, uint32_t argc) {
+  return arithmetic<Multiply>(args, argc, 0, 1);
 }
 
-Parse_Node *builtin_less_than(Parse_Node *args, Symbol_Table *env) {
-  if (args->first == nullptr) {
-    fprintf(stderr,"Error: not enough arguments\n");
-    return nullptr;
-  }
-  Parse_Node *prev = eval_parse_node(args->first, env);
-  bool prev_int = (prev->subtype == LITERAL_INTEGER);
-  
-  if (!is_number(prev)) {
-    fprintf(stderr, "Error: argument 1, %s, is not a number\n",
-	    prev->print().c_str());
-    return nullptr;
-  }
-  Parse_Node *cur = args->next;
-  while (cur->first != nullptr) {
-    Parse_Node *ecur = eval_parse_node(cur->first, env);
-    if (!is_number(ecur)) {
-      fprintf(stderr, "Error: argument %s, is not a number",
-	      cur->first->print().c_str());
-      return nullptr;      
-    }
-    bool cur_int = (ecur->subtype == LITERAL_INTEGER);
-    if (prev_int) {
-      if (cur_int) {
-	if (! (prev->val.u64 < ecur->val.u64)) {return fal;}
-      } else {
-	if (! (prev->val.u64 < ecur->val.dub)) {return fal;}
-      }
-    } else {
-      if (cur_int) {
-	if (! (prev->val.dub < ecur->val.u64)) {return fal;}
-      } else {
-	if (! (prev->val.dub < ecur->val.dub)) {return fal;}
+struct Less {
+  template <typename T> static bool holds(T a, T b) { return a < b; }
+};
+
+struct Less_Equal {
+  template <typename T> static bool holds(T a, T b) { return a <= b; }
+};
+
+struct Greater {
+  template <typename T> static bool holds(T a, T b) { return a > b; }
+};
+
+struct Greater_Equal {
+  template <typename T> static bool holds(T a, T b) { return a >= b; }
+};
+
+struct Equal {
+  template <typename T> static bool holds(T a, T b) { return a == b; }
+};
+
+// whether every adjacent pair of args is ordered by Cmp, stops at the first
+// pair that isn't
+template <typename Cmp>
+static Parse_Node *compare(const char *name, Parse_Node **args, uint32_t argc) {
+  Parse_Node *error = check_number(name, args[0]);
+  if (error != nullptr) {
+    return error;
+  }
+  for (uint32_t i = 1; i < argc; i++) {
+    Parse_Node *a = args[i - 1];
+    Parse_Node *b = args[i];
+    if (is_fixnum(a) && is_fixnum(b)) {
+      if (!Cmp::holds(fixnum_value(a), fixnum_value(b))) {
+	return fal;
       }
+      continue;
     }
-    prev = ecur;
-    prev_int = cur_int;
-    cur = cur->next;
-  }
-  return tru;
-}
-
-Parse_Node *builtin_less_than_equal(Parse_Node *args, Symbol_Table *env) {
-  if (args->first == nullptr) {
-    fprintf(stderr,"Error: not enough arguments\n");
-    return nullptr;
-  }
-  Parse_Node *prev = eval_parse_node(args->first, env);
-  bool prev_int = (prev->subtype == LITERAL_INTEGER);
-  
-  if (!is_number(prev)) {
-    fprintf(stderr, "Error: argument 1, %s, is not a number\n",
-	    prev->print().c_str());
-    return nullptr;
-  }
-  Parse_Node *cur = args->next;
-  while (cur->first != nullptr) {
-    Parse_Node *ecur = eval_parse_node(cur->first, env);
-    if (!is_number(ecur)) {
-      fprintf(stderr, "Error: argument %s, is not a number",
-	      cur->first->print().c_str());
-      return nullptr;      
+    error = check_number(name, b);
+    if (error != nullptr) {
+      return error;
     }
-    bool cur_int = (ecur->subtype == LITERAL_INTEGER);
-    if (prev_int) {
-      if (cur_int) {
-	if (! (prev->val.u64 <= ecur->val.u64)) {return fal;}
-      } else {
-	if (! (prev->val.u64 <= ecur->val.dub)) {return fal;}
-      }
+    bool holds;
+    if (is_integer(a) && is_integer(b)) {
+      holds = Cmp::holds(integer_value(a), integer_value(b));
+    } else if ((is_integer(a) || is_bignum(a)) && (is_integer(b) || is_bignum(b))) {
+      holds = Cmp::holds(bignum_compare(to_bignum(a), to_bignum(b)), 0);
     } else {
-      if (cur_int) {
-	if (! (prev->val.dub <= ecur->val.u64)) {return fal;}
-      } else {
-	if (! (prev->val.dub <= ecur->val.dub)) {return fal;}
-      }
-    }    
-    prev = ecur;
-    prev_int = cur_int;
-    cur = cur->next;
+      holds = Cmp::holds(as_double(a), as_double(b));
+    }
+    if (!holds) {
+      return fal;
+    }
   }
   return tru;
 }
 
-Parse_Node *builtin_equal(Parse_Node *args, Symbol_Table *env) {
-  if (args->first == nullptr) {
-    fprintf(stderr, "Error: not enough arguments\n");
-    return nullptr;
-  }
-
-  double dval;
-  int val;
+Parse_Node *builtin_greater_than_equal(Parse_Node **args, uint32_t argc) {
+  return compare<Greater_Equal>(">=", args, argc);
+}
 
-  Parse_Node *first = eval_parse_node(args->first, env);
-  if (!is_number(first)) {
-    fprintf(stderr, "Error: argument %s is not a number\n", args->first->print().c_str());
-    return nullptr;
-  }
-  
-  bool is_int = (first->subtype == LITERAL_INTEGER);
-  if (is_int) {
-    val = first->val.u64;
-  } else {
-    dval = first->val.dub;
-  }
+Parse_Node *builtin_greater_than(Parse_Node **args, uint32_t argc) {
+  return compare<Greater>(">", args, argc);
+}
 
-  Parse_Node *cur = args->next;
-  while(cur->first != nullptr) {
-    Parse_Node *ecur = eval_parse_node(cur->first, env);
-    if (!is_number(ecur)) {
-      fprintf(stderr, "Error: argument %s, is not a number",
-	      cur->first->print().c_str());
-      return nullptr;      
-    }
-    bool cur_int = (ecur->subtype == LITERAL_INTEGER);          
-    if (is_int) {
-      if (cur_int) {
-	if (! (val == ecur->val.u64)) {return fal;}
-      } else {
-	if (! (val == ecur->val.dub)) {return fal;}
-      }
-    } else {
-      if (cur_int) {
-	if (! (dval == ecur->val.u64)) {return fal;}
-      } else {
-	if (! (dval == ecur->val.dub)) {return fal;}
-      }
-    }
-    cur = cur->next;
-  }
-  return tru;  
+Parse_Node *builtin_less_than(Parse_Node **args, uint32_t argc) {
+  return compare<Less>("<", args, argc);
 }
 
-Parse_Node *builtin_bitand(Parse_Node *args, Symbol_Table *env) {
-  if (args->length() != 2) {
-    fprintf(stderr, "Error: takes 2+ arguments\n");
-    return nullptr;
-  }
+Parse_Node *builtin_less_than_equal(Parse_Node **args, uint32_t argc) {
+  return compare<Less_Equal>("<=", args, argc);
+}
 
-  Parse_Node *earg = eval_parse_node(args->first, env);
+Parse_Node *builtin_equal(Parse_Node **args, uint32_t argc) {
+  return compare<Equal>("=", args, argc);
+}
 
-  if(!is_number(earg)) {
-    fprintf(stderr, "Error: argument %s is not a number\n", args->first->print().c_str());
-    return nullptr;
+// the bitwise operators work on 64 bit words, a float's bits are used as
+// they are
+static int64_t word_value(const char *name, Parse_Node *arg) {
+  if (!is_number(arg)) {
+    throw runtimeError(std::string("Error: ") + name + " was given non-number argument " +
+		       print_node(arg) + "\n");
   }
-  
-  int64_t val;
-  if (earg->subtype == LITERAL_INTEGER) {
-    val = earg->val.u64;
-  } else {
-    val = *((int64_t *)(&earg->val.dub));
+  if (is_bignum(arg)) {
+    throw runtimeError(std::string("Error: ") + name + " was given argument " +
+		       print_node(arg) + ", which doesn't fit in 64 bits\n");
   }
-
-  Parse_Node *cur = args->next;
-  while (cur->first != nullptr) {
-    earg = eval_parse_node(cur->first, env);
-
-    if(!is_number(earg)) {
-      fprintf(stderr, "Error: argument %s is not a number\n", cur->first->print().c_str());
-      return nullptr;
-    }
-    
-    if (earg->subtype == LITERAL_INTEGER) {
-      val &= earg->val.u64;
-    } else {
-      val &= *((int64_t *)(&earg->val.dub));
-    }
-    cur = cur->next;
+  if (is_integer(arg)) {
+    return integer_value(arg);
   }
-  Parse_Node *r = new Parse_Node{PARSE_NODE_LITERAL, LITERAL_INTEGER};
-  r->val.u64 = val;
-  return r;
+  return *((int64_t *)(&arg->val.dub));
 }
 
-Parse_Node *builtin_bitor(Parse_Node *args, Symbol_Table *env) {
-  if (args->length() != 2) {
-    fprintf(stderr, "Error: takes 2+ arguments\n");
-    return nullptr;
+static int64_t shift_count(const char *name, Parse_Node **args, uint32_t argc) {
+  if (argc == 1) {
+    return 1;
   }
-
-  Parse_Node *earg = eval_parse_node(args->first, env);
-
-  if(!is_number(earg)) {
-    fprintf(stderr, "Error: argument %s is not a number\n", args->first->print().c_str());
-    return nullptr;
+  if (!is_integer(args[1])) {
+    throw runtimeError(std::string("Error: ") + name + " was given non-integer shift " +
+		       print_node(args[1]) + "\n");
   }
-  
-  int64_t val;
-  if (earg->subtype == LITERAL_INTEGER) {
-    val = earg->val.u64;
-  } else {
-    val = *((int64_t *)(&earg->val.dub));
+  int64_t count = integer_value(args[1]);
+  if (count < 0 || count > 63) {
+    throw runtimeError(std::string("Error: ") + name + " shift count " + std::to_string(count) +
+		       " is not between 0 and 63\n");
   }
+  return count;
+}
 
-  Parse_Node *cur = args->next;
-  while (cur->first != nullptr) {
-    earg = eval_parse_node(cur->first, env);
-
-    if(!is_number(earg)) {
-      fprintf(stderr, "Error: argument %s is not a number\n", cur->first->print().c_str());
-      return nullptr;
-    }
-    
-    if (earg->subtype == LITERAL_INTEGER) {
-      val |= earg->val.u64;
-    } else {
-      val |= *((int64_t *)(&earg->val.dub));
+// returns the first argument that is an error value, which becomes the
+// result, or nullptr
+static Parse_Node *error_argument(Parse_Node **args, uint32_t argc) {
+  for (uint32_t i = 0; i < argc; i++) {
+    if (is_error(args[i])) {
+      return args[i];
     }
-    cur = cur->next;
   }
-  Parse_Node *r = new Parse_Node{PARSE_NODE_LITERAL, LITERAL_INTEGER};
-  r->val.u64 = val;
-  return r;
+  return nullptr;
 }
 
-Parse_Node *builtin_bitxor(Parse_Node *args, Symbol_Table *env) {
-  if (args->length() != 2) {
-    fprintf(stderr, "Error: takes 2+ arguments\n");
-    return nullptr;
-  }
-
-  Parse_Node *earg = eval_parse_node(args->first, env);
-
-  if(!is_number(earg)) {
-    fprintf(stderr, "Error: argument %s is not a number\n", args->first->print().c_str());
-    return nullptr;
+Parse_Node *builtin_bitand(Parse_Node **args, uint32_t argc) {
+  Parse_Node *error = error_argument(args, argc);
+  if (error != nullptr) {
+    return error;
   }
-  
-  int64_t val;
-  if (earg->subtype == LITERAL_INTEGER) {
-    val = earg->val.u64;
-  } else {
-    val = *((int64_t *)(&earg->val.dub));
+  int64_t val = word_value("&", args[0]);
+  for (uint32_t i = 1; i < argc; i++) {
+    val &= word_value("&", args[i]);
   }
-
-  Parse_Node *cur = args->next;
-  while (cur->first != nullptr) {
-    earg = eval_parse_node(cur->first, env);
-
-    if(!is_number(earg)) {
-      fprintf(stderr, "Error: argument %s is not a number\n", cur->first->print().c_str());
-      return nullptr;
-    }
-    
-    if (earg->subtype == LITERAL_INTEGER) {
-      val ^= earg->val.u64;
-    } else {
-      val ^= *((int64_t *)(&earg->val.dub));
-    }
-    cur = cur->next;
-  }
-  Parse_Node *r = new Parse_Node{PARSE_NODE_LITERAL, LITERAL_INTEGER};
-  r->val.u64 = val;
-  return r;
+  return make_integer(val);
 }
 
-Parse_Node *builtin_bitnot(Parse_Node *args, Symbol_Table *env) {
-  if (args->length() != 1) {
-    fprintf(stderr, "Error: takes 1 argument\n");
-    return nullptr;
+Parse_Node *builtin_bitor(Parse_Node **args, uint32_t argc) {
+  Parse_Node *error = error_argument(args, argc);
+  if (error != nullptr) {
+    return error;
   }
-
-  Parse_Node *earg = eval_parse_node(args->first, env);
-
-  if(!is_number(earg)) {
-    fprintf(stderr, "Error: argument %s is not a number\n", args->first->print().c_str());
-    return nullptr;
-  }
-  
-  int64_t val;
-  if (earg->subtype == LITERAL_INTEGER) {
-    val = ~earg->val.u64;
-  } else {
-    val = ~*((int64_t *)(&earg->val.dub));
+  int64_t val = word_value("|", args[0]);
+  for (uint32_t i = 1; i < argc; i++) {
+    val |= word_value("|", args[i]);
   }
-
-  Parse_Node *r = new Parse_Node{PARSE_NODE_LITERAL, LITERAL_INTEGER};
-  r->val.u64 = val;
-  return r;
+  return make_integer(val);
 }
 
-Parse_Node *builtin_bitshift_left(Parse_Node *args, Symbol_Table *env) {
-  int nargs = args->length();
-  if (nargs != 2 && nargs != 1) {
-    fprintf(stderr, "Error: takes 1 or 2 arguments\n");
-    return nullptr;
-  }
-
-  Parse_Node *earg = eval_parse_node(args->first, env);
-
-  if(!is_number(earg)) {
-    fprintf(stderr, "Error: argument %s is not a number\n", args->first->print().c_str());
-    return nullptr;
-  }
-  
-  int64_t val;
-  if (earg->subtype == LITERAL_INTEGER) {
-    val = earg->val.u64;
-  } else {
-    val = *((int64_t *)(&earg->val.dub));
+Parse_Node *builtin_bitxor(Parse_Node **args, uint32_t argc) {
+  Parse_Node *error = error_argument(args, argc);
+  if (error != nullptr) {
+    return error;
   }
-
-  if (nargs == 1) {
-    val <<= 1; 
-  } else {
-    Parse_Node *earg = eval_parse_node(args->next->first, env);
-    if(earg->subtype != LITERAL_INTEGER) {
-      fprintf(stderr, "Error: argument %s is not an integer\n", args->next->first->print().c_str());
-      return nullptr;
-    }
-    val <<= earg->val.u64;    
+  int64_t val = word_value("^", args[0]);
+  for (uint32_t i = 1; i < argc; i++) {
+    val ^= word_value("^", args[i]);
   }
-
-  Parse_Node *r = new Parse_Node{PARSE_NODE_LITERAL, LITERAL_INTEGER};
-  r->val.u64 = val;
-  return r;
+  return make_integer(val);
 }
 
-Parse_Node *builtin_bitshift_right(Parse_Node *args, Symbol_Table *env) {
-  int nargs = args->length();
-  if (nargs != 2 && nargs != 1) {
-    fprintf(stderr, "Error: takes 1 or 2 arguments\n");
-    return nullptr;
+Parse_Node *builtin_bitnot(Parse_Node **args, uint32_t argc) {
+  Parse_Node *error = error_argument(args, argc);
+  if (error != nullptr) {
+    return error;
   }
+  return make_integer(~word_value("~", args[0]));
+}
 
-  Parse_Node *earg = eval_parse_node(args->first, env);
-
-  if(!is_number(earg)) {
-    fprintf(stderr, "Error: argument %s is not a number\n", args->first->print().c_str());
-    return nullptr;
-  }
-  
-  int64_t val;
-  if (earg->subtype == LITERAL_INTEGER) {
-    val = earg->val.u64;
-  } else {
-    val = *((int64_t *)(&earg->val.dub));
-  }
+Parse_Node *builtin_bitshift_left(Parse_Node **args, uint32_t argc) {
+  Parse_Node *error = error_argument(args, argc);
+  if (error != nullptr) {
+    return error;
+  }
+  int64_t val = word_value("<<", args[0]);
+  int64_t count = shift_count("<<", args, argc);
+  // the operators stay within 64 bit words, shifting bits out, the sign
+  // bit included, is an error rather than a bignum or a wrapped word
+  int64_t shifted = (int64_t)((uint64_t)val << count);
+  if ((shifted >> count) != val) {
+    throw runtimeError("Error: << of " + print_node(args[0]) + " by " + std::to_string(count) +
+		       " doesn't fit in 64 bits\n");
+  }
+  return make_integer(shifted);
+}
 
-  if (nargs == 1) {
-    val >>= 1; 
-  } else {
-    Parse_Node *earg = eval_parse_node(args->next->first, env);
-    if(earg->subtype != LITERAL_INTEGER) {
-      fprintf(stderr, "Error: argument %s is not an integer\n", args->next->first->print().c_str());
-      return nullptr;
-    }
-    val >>= earg->val.u64;    
+Parse_Node *builtin_bitshift_right(Parse_Node **args, uint32_t argc) {
+  Parse_Node *error = error_argument(args, argc);
+  if (error != nullptr) {
+    return error;
   }
-
-  Parse_Node *r = new Parse_Node{PARSE_NODE_LITERAL, LITERAL_INTEGER};
-  r->val.u64 = val;
-  return r;
+  int64_t val = word_value(">>", args[0]);
+  return make_integer(val >> shift_count(">>", args, argc));
 }
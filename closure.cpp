@@ -0,0 +1,871 @@
+#include <unordered_map>
+#include "closure.h"
+#include "interp.h"
+#include "builtin_helpers.h"
+#include "builtin_logic.h"
+#include "builtin_math.h"
+
+// calls with more arguments than this are left to the tree-walker, the
+// values are kept in an array on the C++ stack where the collector sees them
+const uint32_t MAX_COMPILED_ARGS = 8;
+
+// bodies of inlined functions are at most this many nodes
+const uint32_t MAX_INLINE_NODES = 16;
+
+bool report_inlining = false;
+
+struct Code {
+  virtual ~Code() {}
+  virtual Parse_Node *run(Symbol_Table *env) = 0;
+};
+
+struct Compiled_Function {
+  Code *body = nullptr;
+  bool simple = true;  // no &rest or &optional, params holds the lambda list
+  std::vector<uint32_t> params;
+
+  // every node the code refers to, rooted for as long as the function lives
+  std::vector<Parse_Node *> roots;
+  std::vector<Code *> code;
+
+  Compiled_Function() { gc_add_root(&roots); }
+  ~Compiled_Function() {
+    gc_remove_root(&roots);
+    for (Code *c : code) {
+      delete c;
+    }
+  }
+  Compiled_Function(const Compiled_Function &) = delete;
+  Compiled_Function &operator=(const Compiled_Function &) = delete;
+};
+
+static std::unordered_map<Parse_Node *, Compiled_Function *> compiled_functions;
+
+static Parse_Node *call_compiled(Parse_Node *fun, Compiled_Function *compiled,
+				 Parse_Node **args, uint32_t argc, bool tail);
+static Compiled_Function *compiled_function(Parse_Node *fun);
+
+//
+// code
+//
+
+struct Const_Code : Code {
+  Parse_Node *value;
+  Parse_Node *run(Symbol_Table *env) { return value; }
+};
+
+struct Nil_Code : Code {
+  Parse_Node *run(Symbol_Table *env) { return new Parse_Node{PARSE_NODE_LIST}; }
+};
+
+static Parse_Node *unbound(uint32_t id) {
+  return error_value("Error: unbound symbol: " + interned_name(id) + "\n");
+}
+
+struct Name_Code : Code {
+  uint32_t id;
+  Parse_Node *run(Symbol_Table *env) {
+    Parse_Node *value = env->bound_value(id);
+    return (value != nullptr) ? value : unbound(id);
+  }
+};
+
+struct Local_Code : Code {
+  uint32_t id;
+  uint64_t address;
+  Parse_Node *run(Symbol_Table *env) {
+    Parse_Node *value = env->bound_value(id, address);
+    return (value != nullptr) ? value : unbound(id);
+  }
+};
+
+struct Eval_Code : Code {
+  Parse_Node *form;
+  bool tail;
+  Parse_Node *run(Symbol_Table *env) {
+    return tail ? eval_tail(form, env) : eval_parse_node(form, env);
+  }
+};
+
+// a macro call translated from its expansion, run as written only while the
+// operator is still the macro that made it and no macro has been defined
+// since, otherwise the call is expanded again by the tree-walker
+struct Macro_Code : Code {
+  uint32_t id;
+  Parse_Node *form;
+  Parse_Node *macro;
+  uint32_t epoch;
+  Code *expansion;
+  bool tail;
+  Parse_Node *run(Symbol_Table *env) {
+    if (epoch == current_macro_epoch() && env->bound_value(id) == macro) {
+      return expansion->run(env);
+    }
+    return tail ? eval_tail(form, env) : eval_parse_node(form, env);
+  }
+};
+
+struct Progn_Code : Code {
+  std::vector<Code *> forms;
+  Parse_Node *run(Symbol_Table *env) {
+    Parse_Node *ret = nullptr;
+    for (Code *form : forms) {
+      ret = form->run(env);
+      if (is_return(ret)) {
+	break;
+      }
+    }
+    return ret;
+  }
+};
+
+struct If_Code : Code {
+  Code *test;
+  Code *then;
+  Code *otherwise;
+  Parse_Node *run(Symbol_Table *env) {
+    Parse_Node *condition = test->run(env);
+    if (is_return(condition)) {
+      return condition;
+    }
+    if (bool_value(condition)) {
+      return then->run(env);
+    }
+    return otherwise->run(env);
+  }
+};
+
+struct While_Code : Code {
+  Code *test;
+  Code *body;
+  Parse_Node *run(Symbol_Table *env) {
+    Parse_Node *ret = nullptr;
+    while (true) {
+      Parse_Node *val = test->run(env);
+      if (is_return(val)) {
+	return val;
+      }
+      if (!is_bool(val)) {
+	fprintf(stderr, "Error: while condition didn't evaluate to a boolean\n");
+	break;
+      }
+      if (!val->val.b) {
+	break;
+      }
+      ret = body->run(env);
+      if (is_return(ret)) {
+	return ret;
+      }
+    }
+    if (ret == nullptr) {
+      ret = new Parse_Node{PARSE_NODE_LIST};
+    }
+    return ret;
+  }
+};
+
+struct Let_Code : Code {
+  std::vector<uint32_t> ids;
+  std::vector<Code *> values;
+  Code *body;
+  Parse_Node *run(Symbol_Table *env) {
+    Symbol_Table *let_env = new Symbol_Table(env);
+    for (size_t i = 0; i < ids.size(); i++) {
+      Parse_Node *value = values[i]->run(let_env);
+      if (is_return(value)) {
+	return value;
+      }
+      let_env->define(ids[i], value);
+    }
+    return body->run(let_env);
+  }
+};
+
+struct Set_Code : Code {
+  Parse_Node *sym;
+  Code *value;
+  Parse_Node *run(Symbol_Table *env) {
+    Parse_Node *val = value->run(env);
+    if (is_return(val)) {
+      return val;
+    }
+    env->set(sym->aux, val);
+    return sym;
+  }
+};
+
+struct Return_Code : Code {
+  Code *value;
+  Parse_Node *run(Symbol_Table *env) {
+    return signal_return(value->run(env));
+  }
+};
+
+// common part of every call, the callee is checked again when the call runs
+// and the whole form goes to the tree-walker if it was redefined
+struct Call_Code : Code {
+  uint32_t id;
+  Parse_Node *form;
+  Parse_Node *expected;  // the builtin, or nullptr for any native function
+  bool guarded = false;  // in an inlined body, Inline_Code checked the builtin
+  std::vector<Code *> args;
+
+  Parse_Node *callee(Symbol_Table *env) {
+    if (guarded) {
+      return expected;
+    }
+    Parse_Node *func = env->bound_value(id);
+    if (func == nullptr || node_type(func) != PARSE_NODE_FUNCTION) {
+      return nullptr;
+    }
+    if (expected == nullptr) {
+      return (func->subtype == FUNCTION_NATIVE) ? func : nullptr;
+    }
+    return (func == expected) ? func : nullptr;
+  }
+
+  // false if an argument returned, the signal is passed up instead of calling
+  bool run_args(Symbol_Table *env, Parse_Node **values) {
+    for (size_t i = 0; i < args.size(); i++) {
+      values[i] = args[i]->run(env);
+      if (is_return(values[i])) {
+	return false;
+      }
+    }
+    return true;
+  }
+};
+
+struct Native_Call_Code : Call_Code {
+  bool tail;  // in tail position, the call is left to run_body's trampoline
+  Parse_Node *run(Symbol_Table *env) {
+    Parse_Node *fun = callee(env);
+    if (fun == nullptr) {
+      return eval_parse_node(form, env);
+    }
+    Parse_Node *values[MAX_COMPILED_ARGS];
+    uint32_t argc = args.size();
+    if (!run_args(env, values)) {
+      return return_signal;
+    }
+    try {
+      Compiled_Function *compiled = compiled_function(fun);
+      if (compiled->simple) {
+	return call_compiled(fun, compiled, values, argc, tail);
+      }
+      // let apply_fun bind the lambda list, it evaluates the quoted values
+      Parse_Node *call = new Parse_Node{PARSE_NODE_LIST};
+      call->first = form->first;
+      call->next = new Parse_Node{PARSE_NODE_LIST};
+      Parse_Node *cur = call->next;
+      for (uint32_t i = 0; i < argc; i++) {
+	Parse_Node *q = new Parse_Node{PARSE_NODE_SYNTAX, SYNTAX_QUOTE};
+	q->first = values[i];
+	cur->first = q;
+	cur->next = new Parse_Node{PARSE_NODE_LIST};
+	cur = cur->next;
+      }
+      if (!tail) {
+	return apply_fun(fun, call, env);
+      }
+      Symbol_Table *frame = bind_arguments(fun, call, env);
+      return (frame != nullptr) ? signal_tail_call(fun, frame) : return_signal;
+    } catch (runtimeError &e) {
+      return error_value(e.what());
+    }
+  }
+};
+
+// The arguments of the innermost running inlined call. An inlined body
+// only calls builtins, anything that runs another inlined call restores
+// this before returning to it.
+static Parse_Node **inline_values = nullptr;
+
+struct Inline_Param_Code : Code {
+  uint32_t index;
+  Parse_Node *run(Symbol_Table *env) { return inline_values[index]; }
+};
+
+// A call to a small function whose body was translated in place. The body
+// runs in the function's definition environment, the global table, with
+// its parameters read from the argument values instead of a frame. If the
+// function or any builtin its body calls was redefined the call runs as a
+// normal call.
+struct Inline_Code : Code {
+  Native_Call_Code *call;
+  Parse_Node *fun;
+  Symbol_Table *scope;
+  std::vector<std::pair<uint32_t, Parse_Node *>> builtins;
+  Code *body;
+
+  Parse_Node *run(Symbol_Table *env) {
+    if (env->bound_value(call->id) != fun) {
+      return call->run(env);
+    }
+    for (auto &builtin : builtins) {
+      if (scope->bound_value(builtin.first) != builtin.second) {
+	return call->run(env);
+      }
+    }
+    Parse_Node *values[MAX_COMPILED_ARGS];
+    if (!call->run_args(env, values)) {
+      return return_signal;
+    }
+    Parse_Node **saved = inline_values;
+    inline_values = values;
+    Parse_Node *ret = body->run(scope);
+    inline_values = saved;
+    return ret;
+  }
+};
+
+static Parse_Node *quoted(Parse_Node *value) {
+  if (node_type(value) == PARSE_NODE_LITERAL || (is_sym(value) && is_keyword(value))) {
+    return value;
+  }
+  Parse_Node *q = new Parse_Node{PARSE_NODE_SYNTAX, SYNTAX_QUOTE};
+  q->first = value;
+  return q;
+}
+
+// value builtins take the values as they are, the others take unevaluated
+// arguments, so the values are passed quoted
+static Parse_Node *call_builtin(Parse_Node *func, Parse_Node **values, uint32_t argc, Symbol_Table *env) {
+  if (func->flags & NODE_VALUE_BUILTIN) {
+    try {
+      return call_values(func, values, argc);
+    } catch (runtimeError &e) {
+      return error_value(e.what());
+    }
+  }
+  Parse_Node *list = new Parse_Node{PARSE_NODE_LIST};
+  Parse_Node *cur = list;
+  for (uint32_t i = 0; i < argc; i++) {
+    cur->first = quoted(values[i]);
+    cur->next = new Parse_Node{PARSE_NODE_LIST};
+    cur = cur->next;
+  }
+  try {
+    return func->val.func(list, env);
+  } catch (runtimeError &e) {
+    return error_value(e.what());
+  }
+}
+
+// a NODE_STRICT_BUILTIN, the arguments are compiled
+struct Strict_Call_Code : Call_Code {
+  Parse_Node *run(Symbol_Table *env) {
+    Parse_Node *func = callee(env);
+    if (func == nullptr) {
+      return eval_parse_node(form, env);
+    }
+    Parse_Node *values[MAX_COMPILED_ARGS];
+    uint32_t argc = args.size();
+    if (!run_args(env, values)) {
+      return return_signal;
+    }
+    return call_builtin(func, values, argc, env);
+  }
+};
+
+// any other builtin gets its argument forms, like eval_list passes them
+struct Builtin_Call_Code : Call_Code {
+  Parse_Node *run(Symbol_Table *env) {
+    Parse_Node *func = callee(env);
+    if (func == nullptr) {
+      return eval_parse_node(form, env);
+    }
+    try {
+      return apply_builtin(func, form->next, env);
+    } catch (runtimeError &e) {
+      return error_value(e.what());
+    }
+  }
+};
+
+enum Arithmetic_Op {
+  ARITH_ADD,
+  ARITH_SUB,
+  ARITH_LT,
+  ARITH_LE,
+  ARITH_GT,
+  ARITH_GE,
+  ARITH_EQ,
+};
+
+// two argument arithmetic and comparisons, fixnums don't go through the builtin
+struct Arithmetic_Code : Call_Code {
+  Arithmetic_Op op;
+  Parse_Node *run(Symbol_Table *env) {
+    Parse_Node *func = callee(env);
+    if (func == nullptr) {
+      return eval_parse_node(form, env);
+    }
+    Parse_Node *values[2];
+    if (!run_args(env, values)) {
+      return return_signal;
+    }
+    if (is_fixnum(values[0]) && is_fixnum(values[1])) {
+      int64_t a = fixnum_value(values[0]);
+      int64_t b = fixnum_value(values[1]);
+      switch (op) {
+      case ARITH_ADD: return make_integer(a + b);
+      case ARITH_SUB: return make_integer(a - b);
+      case ARITH_LT: return (a < b) ? tru : fal;
+      case ARITH_LE: return (a <= b) ? tru : fal;
+      case ARITH_GT: return (a > b) ? tru : fal;
+      case ARITH_GE: return (a >= b) ? tru : fal;
+      case ARITH_EQ: return (a == b) ? tru : fal;
+      }
+    }
+    return call_builtin(func, values, 2, env);
+  }
+};
+
+//
+// translation
+//
+
+struct Translator {
+  Compiled_Function *fun;
+  Symbol_Table *env;  // operators are looked up here at translation time
+  Parse_Node *function;  // the function being translated, for the inlining report
+
+  // set while translating an inlined body
+  const std::vector<uint32_t> *inline_params = nullptr;
+  std::vector<std::pair<uint32_t, Parse_Node *>> *inline_builtins = nullptr;
+
+  template <typename T> T *make() {
+    T *c = new T();
+    fun->code.push_back(c);
+    return c;
+  }
+  Parse_Node *root(Parse_Node *node) {
+    fun->roots.push_back(node);
+    return node;
+  }
+
+  Code *constant(Parse_Node *node);
+  Code *nil() { return make<Nil_Code>(); }
+  // tail is set for forms whose value is the value of the function
+  Code *eval(Parse_Node *node, bool tail);
+  Code *translate(Parse_Node *node, bool tail = false);
+  Code *translate_body(Parse_Node *forms, bool tail);
+  Code *translate_call(Parse_Node *node, bool tail);
+  Code *translate_special(Parse_Node *(*builtin)(Parse_Node *, Symbol_Table *), Parse_Node *args, bool tail);
+  Code *translate_let(Parse_Node *args, bool tail);
+  Code *translate_inline(Parse_Node *node, Parse_Node *callee, Native_Call_Code *call);
+  template <typename T> T *call(Parse_Node *node, Parse_Node *expected, bool translate_args);
+};
+
+Code *Translator::constant(Parse_Node *node) {
+  Const_Code *c = make<Const_Code>();
+  c->value = root(node);
+  return c;
+}
+
+Code *Translator::eval(Parse_Node *node, bool tail) {
+  Eval_Code *c = make<Eval_Code>();
+  c->form = root(node);
+  c->tail = tail;
+  return c;
+}
+
+// forms is a non empty list, only the last form can be in tail position
+Code *Translator::translate_body(Parse_Node *forms, bool tail) {
+  if (is_empty_list(forms->next)) {
+    return translate(forms->first, tail);
+  }
+  Progn_Code *c = make<Progn_Code>();
+  for (; !is_empty_list(forms); forms = forms->next) {
+    c->forms.push_back(translate(forms->first, tail && is_empty_list(forms->next)));
+  }
+  return c;
+}
+
+Code *Translator::translate(Parse_Node *node, bool tail) {
+  check_call_depth();
+  switch (node_type(node)) {
+  case PARSE_NODE_LITERAL:
+    return constant(node);
+
+  case PARSE_NODE_SYMBOL: {
+    if (is_keyword(node)) {
+      return constant(node);
+    }
+    if (inline_params != nullptr) {
+      for (uint32_t i = 0; i < inline_params->size(); i++) {
+	if ((*inline_params)[i] == node->aux) {
+	  Inline_Param_Code *c = make<Inline_Param_Code>();
+	  c->index = i;
+	  return c;
+	}
+      }
+      Name_Code *c = make<Name_Code>();
+      c->id = node->aux;
+      return c;
+    }
+    if (node->flags & NODE_LEXICAL_ADDRESS) {
+      Local_Code *c = make<Local_Code>();
+      c->id = node->aux;
+      c->address = node->val.u64;
+      return c;
+    }
+    Name_Code *c = make<Name_Code>();
+    c->id = node->aux;
+    return c;
+  }
+
+  case PARSE_NODE_SYNTAX:
+    if (node->subtype == SYNTAX_QUOTE) {
+      return constant(node->first);
+    }
+    return eval(node, false);
+
+  case PARSE_NODE_LIST: {
+    if (is_empty_list(node)) {
+      return constant(node);
+    }
+    Code *c = translate_call(node, tail);
+    return (c != nullptr) ? c : eval(node, tail);
+  }
+
+  default:
+    return eval(node, false);
+  }
+}
+
+Code *Translator::translate_let(Parse_Node *args, bool tail) {
+  if (is_empty_list(args) || !is_list(args->first)) {
+    return nullptr;
+  }
+  Let_Code *c = make<Let_Code>();
+  for (Parse_Node *defs = args->first; !is_empty_list(defs); defs = defs->next) {
+    Parse_Node *let_form = defs->first;
+    if (is_sym(let_form)) {
+      c->ids.push_back(let_form->aux);
+      c->values.push_back(nil());
+      continue;
+    }
+    if (!is_list(let_form)) {
+      return nullptr;
+    }
+    int lfs = let_form->length();
+    if ((lfs != 1 && lfs != 2) || !is_sym(let_form->first)) {
+      return nullptr;
+    }
+    c->ids.push_back(let_form->first->aux);
+    c->values.push_back(lfs == 1 ? nil() : translate(let_form->next->first));
+  }
+  c->body = is_empty_list(args->next) ? nil() : translate_body(args->next, tail);
+  return c;
+}
+
+// the builtins that don't evaluate their arguments like a function call,
+// returns nullptr for shapes the builtin itself would report an error for
+Code *Translator::translate_special(Parse_Node *(*builtin)(Parse_Node *, Symbol_Table *), Parse_Node *args, bool tail) {
+  int argc = args->length();
+
+  if (builtin == builtin_quote && argc == 1) {
+    return constant(args->first);
+  }
+
+  if (builtin == builtin_if && (argc == 2 || argc == 3)) {
+    If_Code *c = make<If_Code>();
+    c->test = translate(args->first);
+    c->then = translate(args->next->first, tail);
+    c->otherwise = (argc == 3) ? translate(args->next->next->first, tail) : nil();
+    return c;
+  }
+
+  if (builtin == builtin_while && argc >= 2) {
+    While_Code *c = make<While_Code>();
+    c->test = translate(args->first);
+    c->body = translate_body(args->next, false);
+    return c;
+  }
+
+  if (builtin == builtin_progn && argc >= 1) {
+    return translate_body(args, tail);
+  }
+
+  if (builtin == builtin_set && argc == 2 && is_sym(args->first)) {
+    Set_Code *c = make<Set_Code>();
+    c->sym = root(args->first);
+    c->value = translate(args->next->first);
+    return c;
+  }
+
+  if (builtin == builtin_return && argc == 1) {
+    Return_Code *c = make<Return_Code>();
+    c->value = translate(args->first);
+    return c;
+  }
+
+  if (builtin == builtin_let) {
+    return translate_let(args, tail);
+  }
+  return nullptr;
+}
+
+template <typename T>
+T *Translator::call(Parse_Node *node, Parse_Node *expected, bool translate_args) {
+  T *c = make<T>();
+  c->id = node->first->aux;
+  c->form = root(node);
+  c->expected = expected;
+  if (inline_builtins != nullptr) {
+    c->guarded = true;
+    inline_builtins->push_back({c->id, expected});
+  }
+  if (translate_args) {
+    for (Parse_Node *arg = node->next; !is_empty_list(arg); arg = arg->next) {
+      c->args.push_back(translate(arg->first));
+    }
+  }
+  return c;
+}
+
+// returns nullptr if the call has to be left to the tree-walker
+Code *Translator::translate_call(Parse_Node *node, bool tail) {
+  Parse_Node *op = node->first;
+  if (!is_sym(op) || (op->flags & NODE_LEXICAL_ADDRESS) || has_splice(node)) {
+    return nullptr;
+  }
+  Parse_Node *func = env->bound_value(op->aux);
+  if (func == nullptr || node_type(func) != PARSE_NODE_FUNCTION) {
+    return nullptr;
+  }
+  uint32_t argc = node->next->length();
+
+  switch (func->subtype) {
+  case FUNCTION_MACRO: {
+    Parse_Node *expansion;
+    try {
+      expansion = expand_macro(func, node, env);
+    } catch (runtimeError &e) {
+      // let the tree-walker report it when the form is run
+      return nullptr;
+    }
+    Macro_Code *c = make<Macro_Code>();
+    c->id = op->aux;
+    c->form = node;
+    c->macro = root(func);
+    c->epoch = current_macro_epoch();
+    c->tail = tail;
+    c->expansion = translate(root(expansion), tail);
+    return c;
+  }
+
+  case FUNCTION_NATIVE: {
+    if (argc > MAX_COMPILED_ARGS) {
+      return nullptr;
+    }
+    Native_Call_Code *c = call<Native_Call_Code>(node, nullptr, true);
+    c->tail = tail;
+    Code *inlined = translate_inline(node, func, c);
+    return (inlined != nullptr) ? inlined : c;
+  }
+
+  case FUNCTION_BUILTIN: {
+    Code *special = translate_special(forms_func(func), node->next, tail);
+    if (special != nullptr) {
+      return special;
+    }
+    root(func);
+    if (!(func->flags & NODE_STRICT_BUILTIN) || argc > MAX_COMPILED_ARGS) {
+      return call<Builtin_Call_Code>(node, func, false);
+    }
+    if (argc == 2) {
+      auto builtin = values_func(func);
+      Arithmetic_Op op;
+      bool arithmetic = true;
+      if (builtin == builtin_add) op = ARITH_ADD;
+      else if (builtin == builtin_subtract) op = ARITH_SUB;
+      else if (builtin == builtin_less_than) op = ARITH_LT;
+      else if (builtin == builtin_less_than_equal) op = ARITH_LE;
+      else if (builtin == builtin_greater_than) op = ARITH_GT;
+      else if (builtin == builtin_greater_than_equal) op = ARITH_GE;
+      else if (builtin == builtin_equal) op = ARITH_EQ;
+      else arithmetic = false;
+      if (arithmetic) {
+	Arithmetic_Code *c = call<Arithmetic_Code>(node, func, true);
+	c->op = op;
+	return c;
+      }
+    }
+    return call<Strict_Call_Code>(node, func, true);
+  }
+
+  default:
+    return nullptr;
+  }
+}
+
+// Whether node only uses what an inlined body can run without a frame:
+// constants, variables, if, progn and strict builtins other than eval. Every
+// node counts against budget.
+static bool inlinable(Parse_Node *node, Symbol_Table *scope, uint32_t &budget) {
+  if (budget == 0) {
+    return false;
+  }
+  budget--;
+  switch (node_type(node)) {
+  case PARSE_NODE_LITERAL:
+  case PARSE_NODE_SYMBOL:
+    return true;
+  case PARSE_NODE_SYNTAX:
+    return node->subtype == SYNTAX_QUOTE;
+  case PARSE_NODE_LIST:
+    break;
+  default:
+    return false;
+  }
+  if (is_empty_list(node)) {
+    return true;
+  }
+  Parse_Node *op = node->first;
+  if (!is_sym(op) || (op->flags & NODE_LEXICAL_ADDRESS) || has_splice(node)) {
+    return false;
+  }
+  Parse_Node *func = scope->bound_value(op->aux);
+  if (func == nullptr || node_type(func) != PARSE_NODE_FUNCTION ||
+      func->subtype != FUNCTION_BUILTIN) {
+    return false;
+  }
+  auto builtin = forms_func(func);
+  uint32_t argc = node->next->length();
+  if (builtin == builtin_quote) {
+    return argc == 1;
+  }
+  bool special = (builtin == builtin_if && (argc == 2 || argc == 3)) ||
+    (builtin == builtin_progn && argc >= 1);
+  bool strict = (func->flags & NODE_STRICT_BUILTIN) && builtin != builtin_eval &&
+    argc <= MAX_COMPILED_ARGS;
+  if (!special && !strict) {
+    return false;
+  }
+  for (Parse_Node *arg = node->next; !is_empty_list(arg); arg = arg->next) {
+    if (!inlinable(arg->first, scope, budget)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Small functions with a plain lambda list whose body only calls builtins
+// are inlined, which also means they can't be recursive. Returns nullptr if
+// callee doesn't qualify.
+Code *Translator::translate_inline(Parse_Node *node, Parse_Node *callee, Native_Call_Code *call) {
+  if (inline_params != nullptr || callee->val.env->is_frame()) {
+    return nullptr;
+  }
+  Parse_Node *body = callee->next;
+  if (is_empty_list(body) || !is_empty_list(body->next)) {
+    return nullptr;
+  }
+  Compiled_Function *compiled = compiled_function(callee);
+  uint32_t budget = MAX_INLINE_NODES;
+  if (!compiled->simple || compiled->params.size() != call->args.size() ||
+      !inlinable(body->first, callee->val.env, budget)) {
+    return nullptr;
+  }
+
+  Inline_Code *c = make<Inline_Code>();
+  c->call = call;
+  c->fun = root(callee);
+  c->scope = callee->val.env;
+  Translator inliner{fun, callee->val.env, function, &compiled->params, &c->builtins};
+  c->body = inliner.translate(body->first);
+
+  if (report_inlining) {
+    const Source_Location *loc = source_location(node);
+    fprintf(stderr, "inlined %s into %s", symbol_name(callee).c_str(),
+	    symbol_name(function).c_str());
+    if (loc != nullptr) {
+      fprintf(stderr, " at %s:%d", loc->file->c_str(), loc->line);
+    }
+    fprintf(stderr, "\n");
+  }
+  return c;
+}
+
+static Compiled_Function *compiled_function(Parse_Node *fun) {
+  if (fun->flags & NODE_HAS_CLOSURE) {
+    auto it = compiled_functions.find(fun);
+    if (it != compiled_functions.end()) {
+      return it->second;
+    }
+  }
+
+  Compiled_Function *compiled = new Compiled_Function();
+  const Lambda_List *params = lambda_list(fun);
+  if (params->is_fixed()) {
+    compiled->params = params->required;
+  } else {
+    compiled->simple = false;
+  }
+  if (compiled->params.size() > MAX_COMPILED_ARGS) {
+    compiled->simple = false;
+  }
+  fun->flags |= NODE_HAS_CLOSURE;
+  compiled_functions[fun] = compiled;
+
+  Translator translator{compiled, fun->val.env, fun};
+  try {
+    compiled->body = is_empty_list(fun->next) ? translator.nil() : translator.translate_body(fun->next, true);
+  } catch (stackExhausted &e) {
+    // a macro expanded at translation time ran out, translate again next time
+    closure_forget(fun);
+    fun->flags &= ~NODE_HAS_CLOSURE;
+    throw;
+  }
+  return compiled;
+}
+
+void closure_forget(Parse_Node *fun) {
+  auto it = compiled_functions.find(fun);
+  if (it != compiled_functions.end()) {
+    delete it->second;
+    compiled_functions.erase(it);
+  }
+}
+
+static Parse_Node *call_compiled(Parse_Node *fun, Compiled_Function *compiled,
+				 Parse_Node **args, uint32_t argc, bool tail) {
+  if (argc < compiled->params.size()) {
+    return error_value("Error: Not enough arguments given to invocation of " +
+		       symbol_name(fun) + "\n");
+  }
+  if (argc > compiled->params.size()) {
+    return error_value("Error: Too many arguments given to invocation of " +
+		       symbol_name(fun) + "\n");
+  }
+  Symbol_Table *frame = new Symbol_Table(fun->val.env);
+  for (uint32_t i = 0; i < argc; i++) {
+    frame->define(compiled->params[i], args[i]);
+  }
+  return tail ? signal_tail_call(fun, frame) : run_body(fun, frame);
+}
+
+Parse_Node *closure_run_body(Parse_Node *fun, Symbol_Table *fun_env) {
+  return compiled_function(fun)->body->run(fun_env);
+}
+
+Parse_Node *closure_apply(Parse_Node *fun, Parse_Node *node, Symbol_Table *env) {
+  Compiled_Function *compiled = compiled_function(fun);
+  uint32_t argc = node->next->length();
+  if (!compiled->simple || argc > MAX_COMPILED_ARGS) {
+    return apply_fun(fun, node, env);
+  }
+  Parse_Node *values[MAX_COMPILED_ARGS];
+  Parse_Node *arg = node->next;
+  for (uint32_t i = 0; i < argc; i++) {
+    values[i] = eval_parse_node(arg->first, env);
+    if (is_return(values[i])) {
+      return return_signal;
+    }
+    arg = arg->next;
+  }
+  return call_compiled(fun, compiled, values, argc, false);
+}
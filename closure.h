@@ -0,0 +1,27 @@
+#pragma once
+#include "parser.h"
+
+// Closure compilation, the default engine (--engine=closure).
+//
+// The first time a native function is called its body is translated into a
+// tree of Code objects. Special forms, operator lookups, macro expansion and
+// the callee kind of every call are decided once, at translation time, and a
+// call to a function with a plain lambda list binds its arguments straight
+// into the new frame. Forms the translator doesn't handle become an Eval node
+// that hands them to the tree-walker. The translation is dropped when the
+// function is collected. Calls to small functions that only call builtins
+// are inlined, see translate_inline.
+
+// set by --report-inlining, every inlined call is reported on stderr when
+// it is translated
+extern bool report_inlining;
+
+// call of a native function from the tree-walker, node is the whole call form
+Parse_Node *closure_apply(Parse_Node *fun, Parse_Node *node, Symbol_Table *env);
+
+// runs the body of fun in fun_env for run_body, the result can be
+// return_signal or tail_call_signal
+Parse_Node *closure_run_body(Parse_Node *fun, Symbol_Table *fun_env);
+
+// called by the collector when a function with NODE_HAS_CLOSURE is freed
+void closure_forget(Parse_Node *fun);
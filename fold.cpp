@@ -0,0 +1,291 @@
+#include <algorithm>
+#include "fold.h"
+#include "interp.h"
+#include "builtin_helpers.h"
+#include "builtin_math.h"
+#include "builtin_logic.h"
+#include "builtin_hash.h"
+
+enum Fold_Args : uint8_t {
+  FOLD_NUMBERS,
+  FOLD_INTEGERS,
+  FOLD_ANY,  // numbers or booleans
+};
+
+struct Foldable {
+  Values_Func func;
+  Fold_Args args;
+};
+
+static const Foldable foldables[] = {
+  {builtin_add, FOLD_NUMBERS},
+  {builtin_subtract, FOLD_NUMBERS},
+  {builtin_multiply, FOLD_NUMBERS},
+  {builtin_equal, FOLD_NUMBERS},
+  {builtin_less_than, FOLD_NUMBERS},
+  {builtin_less_than_equal, FOLD_NUMBERS},
+  {builtin_greater_than, FOLD_NUMBERS},
+  {builtin_greater_than_equal, FOLD_NUMBERS},
+  {builtin_bitand, FOLD_NUMBERS},
+  {builtin_bitor, FOLD_NUMBERS},
+  {builtin_bitxor, FOLD_NUMBERS},
+  {builtin_bitnot, FOLD_NUMBERS},
+  {builtin_bitshift_left, FOLD_INTEGERS},
+  {builtin_bitshift_right, FOLD_INTEGERS},
+  {builtin_not, FOLD_ANY},
+};
+
+static const Foldable *foldable(Parse_Node *builtin) {
+  for (const Foldable &f : foldables) {
+    if (f.func == values_func(builtin)) {
+      return &f;
+    }
+  }
+  return nullptr;
+}
+
+struct Folder {
+  Symbol_Table *env;
+  // names bound by the lets, for-eachs and lambda lists around the form
+  // being folded, and names the top level form defines or sets
+  std::vector<uint32_t> locals;
+  std::vector<uint32_t> redefined;
+
+  void find_redefinitions(Parse_Node *node);
+  bool is_shadowed(uint32_t id);
+  Parse_Node *global(Parse_Node *sym);
+  Parse_Node *constant_value(Parse_Node *node);
+  Parse_Node *fold(Parse_Node *node);
+  Parse_Node *fold_builtin(Parse_Node *node, Parse_Node *builtin);
+  Parse_Node *fold_call(Parse_Node *node, Parse_Node *builtin, const Foldable *f);
+  void fold_args(Parse_Node *args);
+  void fold_body(Parse_Node *before);
+  void bind_params(Parse_Node *params);
+};
+
+void Folder::find_redefinitions(Parse_Node *node) {
+  static const uint32_t definers[] = {
+    intern_symbol("defun"), intern_symbol("defmacro"),
+    intern_symbol("defsym"), intern_symbol("set"),
+  };
+  for (; node_type(node) == PARSE_NODE_LIST && !is_empty_list(node); node = node->next) {
+    Parse_Node *op = node->first;
+    if (is_sym(op) && !is_empty_list(node->next) && is_sym(node->next->first) &&
+	std::find(std::begin(definers), std::end(definers), op->aux) != std::end(definers)) {
+      redefined.push_back(node->next->first->aux);
+    }
+    find_redefinitions(node->first);
+  }
+}
+
+bool Folder::is_shadowed(uint32_t id) {
+  return std::find(locals.begin(), locals.end(), id) != locals.end() ||
+    std::find(redefined.begin(), redefined.end(), id) != redefined.end();
+}
+
+// global value of sym, nullptr when it's unbound or may not be the global
+Parse_Node *Folder::global(Parse_Node *sym) {
+  if (!is_sym(sym) || is_shadowed(sym->aux)) {
+    return nullptr;
+  }
+  return env->bound_value(sym->aux);
+}
+
+// number and boolean literals, and the symbols true and false
+Parse_Node *Folder::constant_value(Parse_Node *node) {
+  if (is_number(node) || is_bool(node)) {
+    return node;
+  }
+  if (is_sym(node) && !is_keyword(node)) {
+    Parse_Node *value = global(node);
+    if (value != nullptr && (value == tru || value == fal)) {
+      return value;
+    }
+  }
+  return nullptr;
+}
+
+static bool is_dead(Parse_Node *node) {
+  return node_type(node) == PARSE_NODE_LITERAL || is_keyword(node) ||
+    node_subtype(node) == SYNTAX_QUOTE;
+}
+
+Parse_Node *Folder::fold(Parse_Node *node) {
+  if (node_type(node) != PARSE_NODE_LIST || is_empty_list(node) || has_splice(node)) {
+    return node;
+  }
+  // an operator that isn't defined yet, or is rebound, may be a macro by
+  // the time the call runs
+  Parse_Node *fun = global(node->first);
+  if (fun == nullptr) {
+    return node;
+  }
+  switch (node_subtype(fun)) {
+  case FUNCTION_BUILTIN:
+    return fold_builtin(node, fun);
+  case FUNCTION_MACRO:
+    return node;
+  default:
+    fold_args(node->next);
+    return node;
+  }
+}
+
+Parse_Node *Folder::fold_builtin(Parse_Node *node, Parse_Node *builtin) {
+  auto func = forms_func(builtin);
+  Parse_Node *args = node->next;
+  uint32_t nargs = args->length();
+  size_t nlocals = locals.size();
+
+  if (func == builtin_quote || func == builtin_expand || func == builtin_inspect_macro) {
+    return node;
+  }
+  if (func == builtin_defun || func == builtin_defmacro) {
+    if (nargs >= 2 && is_list(args->next->first)) {
+      bind_params(args->next->first);
+      fold_body(args->next);
+      locals.resize(nlocals);
+    }
+    return node;
+  }
+  if (func == builtin_let) {
+    if (nargs >= 1 && is_list(args->first)) {
+      for (Parse_Node *defs = args->first; !is_empty_list(defs); defs = defs->next) {
+	Parse_Node *def = defs->first;
+	Parse_Node *name = is_list(def) && !is_empty_list(def) ? def->first : def;
+	if (is_sym(name)) {
+	  locals.push_back(name->aux);
+	}
+      }
+      for (Parse_Node *defs = args->first; !is_empty_list(defs); defs = defs->next) {
+	Parse_Node *def = defs->first;
+	if (is_list(def) && def->length() == 2) {
+	  def->next->first = fold(def->next->first);
+	}
+      }
+      fold_body(args);
+      locals.resize(nlocals);
+    }
+    return node;
+  }
+  if (func == builtin_for_each) {
+    Parse_Node *spec = args->first;
+    if (nargs >= 1 && is_list(spec) && spec->length() == 2 && is_sym(spec->first)) {
+      spec->next->first = fold(spec->next->first);
+      locals.push_back(spec->first->aux);
+      fold_args(args->next);
+      locals.resize(nlocals);
+    }
+    return node;
+  }
+  if (func == builtin_hash_for_each) {
+    Parse_Node *spec = args->first;
+    if (nargs >= 1 && is_list(spec) && spec->length() == 3 &&
+	is_sym(spec->first) && is_sym(spec->next->first)) {
+      spec->next->next->first = fold(spec->next->next->first);
+      locals.push_back(spec->first->aux);
+      locals.push_back(spec->next->first->aux);
+      fold_args(args->next);
+      locals.resize(nlocals);
+    }
+    return node;
+  }
+  if (func == builtin_set || func == builtin_defsym) {
+    if (nargs == 2) {
+      args->next->first = fold(args->next->first);
+    }
+    return node;
+  }
+  if (func == builtin_progn) {
+    fold_body(node);
+    return node->next->length() == 1 ? node->next->first : node;
+  }
+
+  fold_args(args);
+  if (func == builtin_if && (nargs == 2 || nargs == 3)) {
+    Parse_Node *condition = constant_value(args->first);
+    if (condition == nullptr && is_dead(args->first)) {
+      condition = args->first;
+    }
+    if (condition != nullptr) {
+      if (bool_value(condition)) {
+	return args->next->first;
+      }
+      if (nargs == 3) {
+	return args->next->next->first;
+      }
+    }
+    return node;
+  }
+
+  const Foldable *f = foldable(builtin);
+  return f != nullptr ? fold_call(node, builtin, f) : node;
+}
+
+Parse_Node *Folder::fold_call(Parse_Node *node, Parse_Node *builtin, const Foldable *f) {
+  const Value_Builtin *b = builtin->val.builtin;
+  uint32_t nargs = node->next->length();
+  if (nargs < b->min_args || nargs > b->max_args) {
+    return node;
+  }
+  std::vector<Parse_Node *> values;
+  for (Parse_Node *arg = node->next; !is_empty_list(arg); arg = arg->next) {
+    Parse_Node *value = constant_value(arg->first);
+    if (value == nullptr ||
+	(f->args == FOLD_NUMBERS && !is_number(value)) ||
+	(f->args == FOLD_INTEGERS && !is_integer(value))) {
+      return node;
+    }
+    values.push_back(value);
+  }
+  Parse_Node *result;
+  try {
+    result = f->func(values.data(), nargs);
+  } catch (runtimeError &e) {
+    // the error is reported when the form runs
+    return node;
+  }
+  if (result == nullptr || is_error(result)) {
+    return node;
+  }
+  return result;
+}
+
+void Folder::fold_args(Parse_Node *args) {
+  for (; !is_empty_list(args); args = args->next) {
+    args->first = fold(args->first);
+  }
+}
+
+// folds the forms after the cell before, constants other than the last form
+// are unlinked
+void Folder::fold_body(Parse_Node *before) {
+  while (!is_empty_list(before->next)) {
+    Parse_Node *cell = before->next;
+    cell->first = fold(cell->first);
+    if (is_dead(cell->first) && !is_empty_list(cell->next)) {
+      before->next = cell->next;
+      invalidate_list_headers();
+    } else {
+      before = cell;
+    }
+  }
+}
+
+void Folder::bind_params(Parse_Node *params) {
+  for (; !is_empty_list(params); params = params->next) {
+    Parse_Node *param = params->first;
+    if (is_list(param) && !is_empty_list(param)) {
+      param = param->first;
+    }
+    if (is_sym(param)) {
+      locals.push_back(param->aux);
+    }
+  }
+}
+
+Parse_Node *fold_constants(Parse_Node *form, Symbol_Table *env) {
+  Folder folder{env};
+  folder.find_redefinitions(form);
+  return folder.fold(form);
+}
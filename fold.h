@@ -0,0 +1,21 @@
+#pragma once
+#include "parser.h"
+
+// Constant folding, run over each top level form just before it is
+// evaluated.
+//
+// A call to a pure arithmetic, comparison, bitwise or logic builtin whose
+// arguments are all number or boolean literals is replaced by its value, an
+// if whose condition folds to a constant by the branch it takes, and
+// constants that aren't the last form of a progn, let or function body are
+// dropped. Operators are checked against their current global bindings and
+// skipped when a surrounding let, for-each, hash-for-each or lambda list
+// binds the name or when the form itself redefines it, so a redefined
+// builtin is never folded. Forms folded before a redefinition keep their
+// folded values.
+// Macro arguments, arguments of calls to operators that aren't defined yet
+// or are rebound, which may turn out to be macros, and quoted and
+// backticked forms are left alone.
+
+// returns the folded form, which may be form itself modified in place
+Parse_Node *fold_constants(Parse_Node *form, Symbol_Table *env);
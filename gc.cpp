@@ -0,0 +1,342 @@
+#include <algorithm>
+#include <chrono>
+#include <csetjmp>
+#include <cstdlib>
+#include <cstdio>
+#include "gc.h"
+#include "slab.h"
+#include "parser.h"
+#include "vm.h"
+#include "closure.h"
+#include "interp.h"
+#include "backtick.h"
+#include "hash_table.h"
+#include "bignum.h"
+
+GC_Stats gc_stats;
+
+// Every object is preceded by a header, the pointer handed out is just past it.
+struct alignas(16) GC_Header {
+  uint32_t kind;
+  uint32_t marked;
+  uint64_t size;
+};
+
+// collect once this many bytes have been allocated since the last collection,
+// the threshold grows with the live heap so collections stay proportional
+static const uint64_t min_collection_threshold = 4 * 1024 * 1024;
+static uint64_t collection_threshold = min_collection_threshold;
+
+static GC_Allocator allocator = GC_ALLOCATOR_SLAB;
+
+// objects that don't come from a slab, everything when allocating with malloc
+static std::vector<GC_Header *> heap_objects;
+static std::vector<GC_Header *> mark_stack;
+
+static std::vector<Parse_Node **> node_roots;
+static std::vector<Symbol_Table *> table_roots;
+static std::vector<Symbol_Table **> table_pointer_roots;
+static std::vector<std::vector<Parse_Node *> *> vector_roots;
+static std::vector<std::vector<Symbol_Table *> *> table_vector_roots;
+
+static char *stack_bottom = nullptr;
+static bool collecting = false;
+
+static GC_Header *header_of(void *obj) {
+  return ((GC_Header *)obj) - 1;
+}
+
+static void *object_of(GC_Header *h) {
+  return (void *)(h + 1);
+}
+
+void gc_init(void *bottom) {
+  stack_bottom = (char *)bottom;
+}
+
+void gc_set_allocator(GC_Allocator a) {
+  allocator = a;
+}
+
+void gc_add_root(Parse_Node **root) {
+  node_roots.push_back(root);
+}
+
+void gc_add_root(Symbol_Table *env) {
+  table_roots.push_back(env);
+}
+
+void gc_add_root(Symbol_Table **root) {
+  table_pointer_roots.push_back(root);
+}
+
+void gc_add_root(std::vector<Parse_Node *> *roots) {
+  vector_roots.push_back(roots);
+}
+
+void gc_add_root(std::vector<Symbol_Table *> *roots) {
+  table_vector_roots.push_back(roots);
+}
+
+void gc_remove_root(std::vector<Parse_Node *> *roots) {
+  auto it = std::find(vector_roots.begin(), vector_roots.end(), roots);
+  if (it != vector_roots.end()) {
+    vector_roots.erase(it);
+  }
+}
+
+void *gc_alloc(size_t size, GC_Kind kind) {
+  if (gc_stats.bytes_since_collection >= collection_threshold && !collecting) {
+    gc_collect();
+  }
+
+  GC_Header *h = nullptr;
+  if (allocator == GC_ALLOCATOR_SLAB) {
+    h = (GC_Header *)slab_alloc(sizeof(GC_Header) + size);
+  }
+  if (h == nullptr) {
+    h = (GC_Header *)malloc(sizeof(GC_Header) + size);
+    if (h == nullptr) {
+      fprintf(stderr, "Error: out of memory\n");
+      exit(1);
+    }
+    heap_objects.push_back(h);
+  }
+  h->kind = kind;
+  h->marked = 0;
+  h->size = size;
+
+  gc_stats.objects_allocated++;
+  gc_stats.live_objects++;
+  gc_stats.live_bytes += size;
+  gc_stats.bytes_since_collection += size;
+  return object_of(h);
+}
+
+void gc_note_external(size_t bytes) {
+  gc_stats.bytes_since_collection += bytes;
+}
+
+static void mark(void *obj) {
+  // fixnums are immediates, there is nothing to mark
+  if (obj == nullptr || ((uintptr_t)obj & 1)) {
+    return;
+  }
+  GC_Header *h = header_of(obj);
+  if (!h->marked) {
+    h->marked = 1;
+    mark_stack.push_back(h);
+  }
+}
+
+static void trace(GC_Header *h) {
+  switch (h->kind) {
+  case GC_NODE: {
+    Parse_Node *node = (Parse_Node *)object_of(h);
+    mark(node->first);
+    mark(node->next);
+    if (node->type == PARSE_NODE_FUNCTION && node->subtype != FUNCTION_BUILTIN) {
+      mark(node->val.env);
+    }
+    if (node->type == PARSE_NODE_VECTOR) {
+      for (Parse_Node *element : *node->val.vec) {
+	mark(element);
+      }
+    }
+    if (node->type == PARSE_NODE_HASH) {
+      node->val.hash->for_each([](Parse_Node *key, Parse_Node *value) {
+	mark(key);
+	mark(value);
+      });
+    }
+    break;
+  }
+  case GC_TABLE: {
+    Symbol_Table *env = (Symbol_Table *)object_of(h);
+    mark(env->parent_table);
+    for (uint32_t i = 0; i < env->capacity; i++) {
+      if (env->entries[i].id != Symbol_Table::EMPTY) {
+	mark(env->entries[i].value);
+      }
+    }
+    break;
+  }
+  }
+}
+
+static void drain_mark_stack() {
+  while (!mark_stack.empty()) {
+    GC_Header *h = mark_stack.back();
+    mark_stack.pop_back();
+    trace(h);
+  }
+}
+
+// heap_objects is sorted by address before this is called
+static GC_Header *find_object(uintptr_t addr) {
+  GC_Header *h = (GC_Header *)slab_find(addr);
+  if (h != nullptr) {
+    return (addr >= (uintptr_t)object_of(h)) ? h : nullptr;
+  }
+
+  auto it = std::upper_bound(heap_objects.begin(), heap_objects.end(), addr,
+			     [](uintptr_t a, GC_Header *h) { return a < (uintptr_t)h; });
+  if (it == heap_objects.begin()) {
+    return nullptr;
+  }
+  h = *(it - 1);
+  uintptr_t start = (uintptr_t)object_of(h);
+  if (addr >= start && addr < start + h->size) {
+    return h;
+  }
+  return nullptr;
+}
+
+__attribute__((noinline, no_sanitize_address))
+static void scan_stack() {
+  char *top = (char *)__builtin_frame_address(0);
+  uintptr_t *cur = (uintptr_t *)((uintptr_t)top & ~(uintptr_t)(sizeof(uintptr_t) - 1));
+  uintptr_t *end = (uintptr_t *)stack_bottom;
+  for (; cur < end; ++cur) {
+    GC_Header *h = find_object(*cur);
+    if (h != nullptr && !h->marked) {
+      h->marked = 1;
+      mark_stack.push_back(h);
+    }
+  }
+}
+
+static void mark_roots() {
+  for (Parse_Node **root : node_roots) {
+    mark(*root);
+  }
+  for (Symbol_Table *env : table_roots) {
+    mark(env);
+  }
+  for (Symbol_Table **root : table_pointer_roots) {
+    mark(*root);
+  }
+  for (std::vector<Parse_Node *> *roots : vector_roots) {
+    for (Parse_Node *node : *roots) {
+      mark(node);
+    }
+  }
+  for (std::vector<Symbol_Table *> *roots : table_vector_roots) {
+    for (Symbol_Table *env : *roots) {
+      mark(env);
+    }
+  }
+  drain_mark_stack();
+
+  // spill callee saved registers so pointers only held in registers are seen
+  jmp_buf regs;
+  __builtin_unwind_init();
+  setjmp(regs);
+  scan_stack();
+  drain_mark_stack();
+}
+
+static void destroy(GC_Header *h) {
+  switch (h->kind) {
+  case GC_NODE: {
+    Parse_Node *node = (Parse_Node *)object_of(h);
+    if (node->type == PARSE_NODE_LITERAL && node->subtype == LITERAL_STRING) {
+      delete node->val.str;
+    }
+    if (node->type == PARSE_NODE_LITERAL && node->subtype == LITERAL_BIGNUM) {
+      delete node->val.big;
+    }
+    if (node->type == PARSE_NODE_VECTOR) {
+      delete node->val.vec;
+    }
+    if (node->type == PARSE_NODE_HASH) {
+      delete node->val.hash;
+    }
+    if (node->type == PARSE_NODE_ARRAY) {
+      if (node->subtype == ARRAY_INT64) {
+	delete node->val.ints;
+      } else {
+	delete node->val.floats;
+      }
+    }
+    if (node->flags & NODE_HAS_LOCATION) {
+      forget_source_location(node);
+    }
+    if (node->flags & NODE_HAS_HEADER) {
+      forget_list_header(node);
+    }
+    if (node->flags & NODE_HAS_CHUNK) {
+      vm_forget_chunk(node);
+    }
+    if (node->flags & NODE_HAS_CLOSURE) {
+      closure_forget(node);
+    }
+    if (node->flags & NODE_HAS_EXPANSION) {
+      macro_forget(node);
+    }
+    if (node->flags & NODE_HAS_TEMPLATE) {
+      backtick_forget(node);
+    }
+    if (node->flags & NODE_HAS_LAMBDA_LIST) {
+      delete node->val.lambda_list;
+    }
+    break;
+  }
+  case GC_TABLE:
+    ((Symbol_Table *)object_of(h))->~Symbol_Table();
+    break;
+  }
+}
+
+static uint64_t swept_live_bytes;
+
+static bool keep_slot(void *slot) {
+  GC_Header *h = (GC_Header *)slot;
+  if (h->marked) {
+    h->marked = 0;
+    swept_live_bytes += h->size;
+    return true;
+  }
+  destroy(h);
+  return false;
+}
+
+uint64_t gc_collect() {
+  if (collecting) {
+    return 0;
+  }
+  collecting = true;
+  auto start = std::chrono::steady_clock::now();
+
+  std::sort(heap_objects.begin(), heap_objects.end());
+  mark_roots();
+
+  uint64_t freed = 0;
+  size_t kept = 0;
+  swept_live_bytes = 0;
+  for (size_t i = 0; i < heap_objects.size(); i++) {
+    GC_Header *h = heap_objects[i];
+    if (keep_slot(h)) {
+      heap_objects[kept++] = h;
+    } else {
+      free(h);
+      freed++;
+    }
+  }
+  heap_objects.resize(kept);
+  freed += slab_sweep(keep_slot);
+  uint64_t live_bytes = swept_live_bytes;
+
+  gc_stats.collections++;
+  gc_stats.objects_freed += freed;
+  gc_stats.live_objects -= freed;
+  gc_stats.live_bytes = live_bytes;
+  gc_stats.bytes_since_collection = 0;
+  collection_threshold = std::max(min_collection_threshold, live_bytes);
+
+  std::chrono::duration<double, std::milli> pause = std::chrono::steady_clock::now() - start;
+  gc_stats.last_pause_ms = pause.count();
+  gc_stats.total_pause_ms += pause.count();
+  collecting = false;
+  return freed;
+}
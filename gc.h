@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct Parse_Node;
+struct Symbol_Table;
+
+// Mark-sweep collector for every Parse_Node and Symbol_Table.
+//
+// The heap is traced precisely, starting from the registered roots (the
+// global environment, tru/fal, the top level forms held by each Parser).
+// The C++ evaluation stack is scanned conservatively: any word that points
+// into a live object keeps it alive, so builtins can hold plain pointers.
+
+enum GC_Kind {
+  GC_NODE,
+  GC_TABLE,
+};
+
+// GC_ALLOCATOR_MALLOC gives every object its own malloc block, it is kept
+// around to benchmark the slab allocator against
+enum GC_Allocator {
+  GC_ALLOCATOR_SLAB,
+  GC_ALLOCATOR_MALLOC,
+};
+
+struct GC_Stats {
+  uint64_t collections = 0;
+  uint64_t objects_allocated = 0;
+  uint64_t objects_freed = 0;
+  uint64_t live_objects = 0;
+  uint64_t live_bytes = 0;
+  uint64_t bytes_since_collection = 0;
+  double last_pause_ms = 0;
+  double total_pause_ms = 0;
+};
+
+extern GC_Stats gc_stats;
+
+// must be called from main before anything is allocated
+void gc_init(void *stack_bottom);
+
+// must be called before anything is allocated
+void gc_set_allocator(GC_Allocator allocator);
+
+void *gc_alloc(size_t size, GC_Kind kind);
+
+// counts memory an object owns outside the heap, such as the elements of a
+// packed array, toward the next collection
+void gc_note_external(size_t bytes);
+
+// returns the number of objects freed
+uint64_t gc_collect();
+
+void gc_add_root(Parse_Node **root);
+void gc_add_root(Symbol_Table *env);
+void gc_add_root(Symbol_Table **root);
+void gc_add_root(std::vector<Parse_Node *> *roots);
+void gc_add_root(std::vector<Symbol_Table *> *roots);
+void gc_remove_root(std::vector<Parse_Node *> *roots);
@@ -0,0 +1,219 @@
+#include <cstdlib>
+#include <cstring>
+#include "hash_table.h"
+#include "builtin_helpers.h"
+#include "bignum.h"
+
+static const uint32_t INITIAL_CAPACITY = 8;
+// old slots moved over by every set and remove while growing, with the
+// table at most 7/8 full the old array is empty by the time the new one,
+// twice the size, is half full
+static const uint32_t MIGRATE_SLOTS = 8;
+
+// the splitmix64 finalizer
+static uint32_t mix(uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ull;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebull;
+  x ^= x >> 31;
+  return (uint32_t)x;
+}
+
+static uint32_t hash_key(Parse_Node *key) {
+  if (is_integer(key)) {
+    return mix(integer_value(key));
+  }
+  if (is_string(key)) {
+    // FNV-1a
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (unsigned char c : string_value(key)) {
+      h = (h ^ c) * 0x100000001b3ull;
+    }
+    return mix(h);
+  }
+  if (is_bignum(key)) {
+    uint64_t h = bignum_value(key).negative;
+    for (uint64_t limb : bignum_value(key).limbs) {
+      h = mix(h ^ limb) + limb;
+    }
+    return mix(h);
+  }
+  return mix(key->aux ^ 0x9e3779b97f4a7c15ull);
+}
+
+static bool keys_equal(Parse_Node *a, Parse_Node *b) {
+  if (a == b) {
+    return true;
+  }
+  // only integers outside the fixnum range are boxed, so a fixnum never
+  // equals a boxed integer
+  if (is_fixnum(a) || is_fixnum(b) || a->type != b->type || a->subtype != b->subtype) {
+    return false;
+  }
+  if (is_integer(a)) {
+    return a->val.u64 == b->val.u64;
+  }
+  if (is_string(a)) {
+    return string_value(a) == string_value(b);
+  }
+  if (is_bignum(a)) {
+    return bignum_compare(bignum_value(a), bignum_value(b)) == 0;
+  }
+  return a->aux == b->aux;
+}
+
+bool is_hash_key(Parse_Node *node) {
+  return is_integer(node) || is_bignum(node) || is_string(node) || is_sym(node);
+}
+
+// calloc, so a big array's pages are zeroed by the kernel as the entries
+// reach them instead of all at once when the table grows
+static Hash_Entry *allocate_entries(uint32_t capacity) {
+  Hash_Entry *entries = (Hash_Entry *)calloc(capacity, sizeof(Hash_Entry));
+  if (entries == nullptr) {
+    fprintf(stderr, "Error: out of memory\n");
+    exit(1);
+  }
+  return entries;
+}
+
+Hash_Table::~Hash_Table() {
+  free(current.entries);
+  free(old.entries);
+}
+
+Hash_Table::Hash_Table(const Hash_Table &other) {
+  for (Array *a : {&current, &old}) {
+    const Array &from = (a == &current) ? other.current : other.old;
+    if (from.capacity != 0) {
+      a->entries = allocate_entries(from.capacity);
+      a->capacity = from.capacity;
+      memcpy(a->entries, from.entries, from.capacity * sizeof(Hash_Entry));
+    }
+  }
+  migrated = other.migrated;
+  count = other.count;
+}
+
+Hash_Entry *Hash_Table::find(Array &a, Parse_Node *key, uint32_t hash) {
+  if (a.capacity == 0) {
+    return nullptr;
+  }
+  uint32_t mask = a.capacity - 1;
+  uint32_t i = hash & mask;
+  for (uint32_t distance = 0;; distance++, i = (i + 1) & mask) {
+    Hash_Entry &e = a.entries[i];
+    if (e.distance == MOVED) {
+      continue;
+    }
+    if (e.key == nullptr || e.distance < distance) {
+      return nullptr;
+    }
+    if (e.hash == hash && keys_equal(e.key, key)) {
+      return &e;
+    }
+  }
+}
+
+// e.key must not be in current
+void Hash_Table::place(Hash_Entry e) {
+  uint32_t mask = current.capacity - 1;
+  uint32_t i = e.hash & mask;
+  e.distance = 0;
+  while (current.entries[i].key != nullptr) {
+    if (current.entries[i].distance < e.distance) {
+      std::swap(current.entries[i], e);
+    }
+    i = (i + 1) & mask;
+    e.distance++;
+  }
+  current.entries[i] = e;
+}
+
+// e is in current
+void Hash_Table::erase(Hash_Entry *e) {
+  uint32_t mask = current.capacity - 1;
+  uint32_t i = e - current.entries;
+  uint32_t next = (i + 1) & mask;
+  while (current.entries[next].key != nullptr && current.entries[next].distance > 0) {
+    current.entries[i] = current.entries[next];
+    current.entries[i].distance--;
+    i = next;
+    next = (next + 1) & mask;
+  }
+  current.entries[i] = Hash_Entry{};
+}
+
+void Hash_Table::migrate(uint32_t slots) {
+  for (; slots > 0 && migrated < old.capacity; slots--, migrated++) {
+    Hash_Entry &e = old.entries[migrated];
+    if (e.key != nullptr) {
+      place(e);
+      e = Hash_Entry{nullptr, nullptr, 0, MOVED};
+    }
+  }
+  if (old.entries != nullptr && migrated == old.capacity) {
+    free(old.entries);
+    old = Array{};
+  }
+}
+
+void Hash_Table::grow() {
+  migrate(UINT32_MAX);
+  uint32_t capacity = (current.capacity == 0) ? INITIAL_CAPACITY : current.capacity * 2;
+  if (current.capacity != 0) {
+    old = current;
+    migrated = 0;
+  }
+  current.entries = allocate_entries(capacity);
+  current.capacity = capacity;
+}
+
+Parse_Node *Hash_Table::get(Parse_Node *key) {
+  uint32_t hash = hash_key(key);
+  Hash_Entry *e = find(current, key, hash);
+  if (e == nullptr) {
+    e = find(old, key, hash);
+  }
+  return (e == nullptr) ? nullptr : e->value;
+}
+
+void Hash_Table::set(Parse_Node *key, Parse_Node *value) {
+  uint32_t hash = hash_key(key);
+  Hash_Entry *e = find(current, key, hash);
+  if (e == nullptr) {
+    e = find(old, key, hash);
+  }
+  if (e != nullptr) {
+    e->value = value;
+    return;
+  }
+  if (is_string(key)) {
+    key = make_string(string_value(key));
+  }
+  // at most 7/8 full
+  if ((count + 1) * 8 > current.capacity * 7) {
+    grow();
+  }
+  place(Hash_Entry{key, value, hash, 0});
+  count++;
+  migrate(MIGRATE_SLOTS);
+}
+
+bool Hash_Table::remove(Parse_Node *key) {
+  uint32_t hash = hash_key(key);
+  Hash_Entry *e = find(current, key, hash);
+  if (e != nullptr) {
+    erase(e);
+  } else {
+    e = find(old, key, hash);
+    if (e == nullptr) {
+      return false;
+    }
+    *e = Hash_Entry{nullptr, nullptr, 0, MOVED};
+  }
+  count--;
+  migrate(MIGRATE_SLOTS);
+  return true;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include "parser.h"
+
+// Hash tables, the values made by make-hash.
+//
+// Open addressing with Robin Hood probing: an insert that reaches an entry
+// closer to its home slot than the one being placed takes over that slot
+// and carries on with the displaced entry. Probe lengths stay short and
+// even, and a lookup stops as soon as it passes an entry nearer its home
+// than the key would be. Removal shifts the entries after it back a slot
+// rather than leaving tombstones.
+//
+// Growing doesn't rehash the whole table at once. The old array is kept and
+// every set or remove moves the next few of its slots into the new one,
+// lookups check both until it's empty. The old array is always emptied
+// before the new one fills up, so no single operation pays for more than a
+// handful of entries.
+//
+// Keys are integers, strings, symbols and keywords. String keys are copied,
+// changing the string afterwards doesn't move the entry.
+
+struct Hash_Entry {
+  Parse_Node *key;  // nullptr when the slot is empty
+  Parse_Node *value;
+  uint32_t hash;
+  uint32_t distance;  // from the home slot, MOVED once migrated or removed
+};
+
+struct Hash_Table {
+  static const uint32_t MOVED = UINT32_MAX;
+
+  Hash_Table() {}
+  ~Hash_Table();
+  // shares the keys and values
+  Hash_Table(const Hash_Table &other);
+  Hash_Table &operator=(const Hash_Table &) = delete;
+
+  // nullptr if key isn't in the table, key must satisfy is_hash_key
+  Parse_Node *get(Parse_Node *key);
+  void set(Parse_Node *key, Parse_Node *value);
+  // false if key wasn't in the table
+  bool remove(Parse_Node *key);
+  uint32_t size() const { return count; }
+
+  // calls f(key, value) for every entry
+  template <typename F>
+  void for_each(F f) {
+    for (Array *a : {&current, &old}) {
+      for (uint32_t i = 0; i < a->capacity; i++) {
+	if (a->entries[i].key != nullptr) {
+	  f(a->entries[i].key, a->entries[i].value);
+	}
+      }
+    }
+  }
+
+private:
+  struct Array {
+    Hash_Entry *entries = nullptr;
+    uint32_t capacity = 0;
+  };
+
+  Array current;
+  Array old;  // being migrated into current, empty otherwise
+  uint32_t migrated = 0;  // slots of old already moved
+  uint32_t count = 0;
+
+  Hash_Entry *find(Array &a, Parse_Node *key, uint32_t hash);
+  void place(Hash_Entry e);
+  void erase(Hash_Entry *e);
+  void grow();
+  void migrate(uint32_t slots);
+};
+
+bool is_hash_key(Parse_Node *node);
@@ -1,27 +1,119 @@
+#include <chrono>
 #include <iostream>
 #include <exception>
 #include <limits>
+#include <unordered_map>
+#include <sys/resource.h>
 #include "interp.h"
 #include "builtin_helpers.h"
 #include "builtin_math.h"
 #include "builtin_logic.h"
 #include "interp_exceptions.h"
+#include "slab.h"
+#include "resolve.h"
+#include "vm.h"
+#include "closure.h"
+#include "backtick.h"
+#include "fold.h"
+#include "builtin_hash.h"
+#include "builtin_array.h"
+#include "hash_table.h"
+#include "bignum.h"
 
 Parse_Node *eval_list(Parse_Node *node, Symbol_Table *env);
-Parse_Node *eval_backtick(Parse_Node *node, Symbol_Table *env);
-Parse_Node *eval_backtick_list(Parse_Node *node, Symbol_Table *env);
 Parse_Node *expand_splice(Parse_Node *node, Symbol_Table *env);
+Parse_Node *eval_vector(Parse_Node *node, Symbol_Table *env);
 Parse_Node *expand_eval_macro(Parse_Node *func, Parse_Node *node, Symbol_Table *env);
-Parse_Node *apply_fun(Parse_Node *fun, Parse_Node *node, Symbol_Table *env);
+Symbol_Table *bind_let(Parse_Node *args, Symbol_Table *env);
+static Lambda_List parse_lambda_list(Parse_Node *param_list, const std::string &obj_type);
+
+Engine engine = ENGINE_CLOSURE;
+
+Parse_Node *return_signal;
+static Parse_Node *pending_return;
+
+Parse_Node *tail_call_signal;
+static Parse_Node *tail_fun;
+static Symbol_Table *tail_env;
+
+Parse_Node *take_return() {
+  Parse_Node *ret = pending_return;
+  pending_return = nullptr;
+  return ret;
+}
+
+Parse_Node *signal_return(Parse_Node *value) {
+  if (!is_return(value)) {
+    pending_return = value;
+  }
+  return return_signal;
+}
+
+uint32_t max_call_depth = 1000000;
+uint32_t call_depth = 0;
+
+static char *native_stack_base;
+static ptrdiff_t native_stack_limit;
+
+static bool native_stack_exhausted() {
+  ptrdiff_t used = native_stack_base - (char *)__builtin_frame_address(0);
+  return used > native_stack_limit;
+}
+
+bool stack_exhausted() {
+  return call_depth >= max_call_depth || native_stack_exhausted();
+}
+
+void check_call_depth() {
+  if (call_depth >= max_call_depth) {
+    throw stackExhausted("Error: stack exhausted after " + std::to_string(call_depth) +
+			 " nested calls\n");
+  }
+  // how many calls fit depends on the engine and on how deep the forms
+  // between them are nested, the count would say little
+  if (native_stack_exhausted()) {
+    throw stackExhausted("Error: stack exhausted, nested too deep for the native stack\n");
+  }
+}
+
+// base is a frame near the bottom of the native stack, a quarter of the
+// stack is kept for whatever runs between two calls
+static void init_native_stack_limit(char *base) {
+  native_stack_base = base;
+  size_t size = 8 * 1024 * 1024;
+  struct rlimit limit;
+  if (getrlimit(RLIMIT_STACK, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY) {
+    size = limit.rlim_cur;
+  }
+  native_stack_limit = size / 4 * 3;
+}
+
+Parse_Node *error_value(const std::string &message) {
+  fprintf(stderr, "%s", message.c_str());
+  return new Parse_Node{PARSE_NODE_ERROR};
+}
+
+// defun, defmacro and defsym always bind here
+static Symbol_Table *global_env;
+
+// lambda list keywords, interned in create_base_environment
+static uint32_t sym_rest;
+static uint32_t sym_opt;
+static uint32_t sym_optional;
 
 Parse_Node *eval_parse_node(Parse_Node *node, Symbol_Table *env) {
   if (node == nullptr) {
     fprintf(stderr, "ERROR: RECEIVED NULLPTR TO EVAL\n");
     exit(1);
   }
+  if (is_fixnum(node)) {
+    return node;
+  }
   try {
     switch (node->type) {
-    case PARSE_NODE_LITERAL: {
+    case PARSE_NODE_LITERAL:
+    case PARSE_NODE_HASH:
+    case PARSE_NODE_ARRAY: {
       return node;
     }
 
@@ -29,13 +121,23 @@ Parse_Node *eval_parse_node(Parse_Node *node, Symbol_Table *env) {
       return eval_list(node, env);
       break;
     }
+
+    case PARSE_NODE_VECTOR: {
+      return eval_vector(node, env);
+    }
     
     case PARSE_NODE_SYMBOL: {
       if (is_keyword(node)) {
 	return node;
       }
     
-      return env->lookup(node->token.name);
+      Parse_Node *value = (node->flags & NODE_LEXICAL_ADDRESS)
+	? env->bound_value(node->aux, node->val.u64)
+	: env->bound_value(node->aux);
+      if (value == nullptr) {
+	return error_value("Error: unbound symbol: " + symbol_name(node) + "\n");
+      }
+      return value;
     }
     case PARSE_NODE_SYNTAX: {
       switch (node->subtype) {
@@ -43,7 +145,7 @@ Parse_Node *eval_parse_node(Parse_Node *node, Symbol_Table *env) {
 	return node->first;      
       }
       case SYNTAX_BACKTICK: {
-	return eval_backtick(node->first, env);
+	return eval_backtick(node, env);
       }
       case SYNTAX_COMMA: {
 	throw runtimeError("Error: comma found not inside backtick\n");
@@ -59,99 +161,254 @@ Parse_Node *eval_parse_node(Parse_Node *node, Symbol_Table *env) {
       fprintf(stderr, "Error: could not evaluate unknown type\n");
       return nullptr;
     }
-  } catch (runtimeError e) {
-    fprintf(stderr, "%s", e.what());
-    return new Parse_Node{PARSE_NODE_ERROR};
+  } catch (runtimeError &e) {
+    return error_value(e.what());
   }
   fprintf(stderr, "Error: ran into unhandled parse_node to eval\n");
   return nullptr;
 }
 
+static uint64_t call_cache_hits = 0;
+static uint64_t call_cache_misses = 0;
+
+// The value of the operator of a call, node is the call and its operator
+// is a symbol. A function bound in the global table is cached on the call
+// site until definition_epoch moves on. The same site can run under
+// different frames, a quoted form passed to eval say, so the frames are
+// searched before the cached function is used unless the resolver found
+// none of them can bind the operator.
+static Parse_Node *call_operator(Parse_Node *node, Symbol_Table *env) {
+  if (node->aux == definition_epoch && (node->flags & NODE_GLOBAL_OPERATOR)) {
+    call_cache_hits++;
+    return node->val.callee;
+  }
+  uint32_t id = node->first->aux;
+  Symbol_Table *table = env;
+  for (; table->is_frame(); table = table->parent_table) {
+    Parse_Node *local = table->find(id);
+    if (local != nullptr) {
+      return local;
+    }
+  }
+  if (node->aux == definition_epoch) {
+    call_cache_hits++;
+    return node->val.callee;
+  }
+  call_cache_misses++;
+  Parse_Node *func = table->find(id);
+  if (func != nullptr && node_type(func) == PARSE_NODE_FUNCTION &&
+      !(node->first->flags & NODE_LEXICAL_ADDRESS) && !(node->flags & NODE_HAS_LAMBDA_LIST)) {
+    node->val.callee = func;
+    node->aux = definition_epoch;
+  }
+  return func;
+}
+
 Parse_Node *eval_list(Parse_Node *node, Symbol_Table *env) {
   // The empty list evaluates to itself
   if (is_empty_list(node)) {
     return node;
   }  
+  // nested forms recurse here whether or not they call anything
+  check_call_depth();
+  Parse_Node *site = node;
   node = expand_splice(node, env);
 
   Parse_Node *func_sym = node->first;
-  if (func_sym->type != PARSE_NODE_SYMBOL) {
-    throw runtimeError( "Error: invalid function call, " + func_sym->print() + " is not a symbol\n" );
+  if (!is_sym(func_sym)) {
+    throw runtimeError( "Error: invalid function call, " + print_node(func_sym) + " is not a symbol\n" );
   }
 
-  Parse_Node *func = env->lookup(func_sym->token.name);
+  Parse_Node *func = call_operator(node, env);
   if (func == nullptr) {
-    throw runtimeError("Error: could not find function or macro named " + func_sym->print() + "\n");
+    return error_value("Error: unbound symbol: " + symbol_name(func_sym) + "\n");
   }
   
-  switch (func->subtype) {
+  switch (node_subtype(func)) {
   case FUNCTION_BUILTIN: 
-    return func->val.func(node->next, env);
+    return apply_builtin(func, node->next, env);
   
   case FUNCTION_MACRO:    
+    if (node != site) {
+      // a spliced call is a new list every time, there is nothing to cache
+      return eval_parse_node(apply_fun(func, node, env), env);
+    }
     return expand_eval_macro(func, node, env);
 
   case FUNCTION_NATIVE:
-    return apply_fun(func, node, env);
+    switch (engine) {
+    case ENGINE_CLOSURE:
+      return closure_apply(func, node, env);
+    case ENGINE_VM:
+      return vm_apply(func, node, env);
+    default:
+      return apply_fun(func, node, env);
+    }
       
   default: 
     throw runtimeError("Error: unknown function subtype\n");
   }
 }
 
+bool has_splice(Parse_Node *list) {
+  if (list->flags & NODE_HAS_LOCATION) {
+    return (list->flags & NODE_HAS_SPLICE) != 0;
+  }
+  for (Parse_Node *cur = list; !is_empty_list(cur); cur = cur->next) {
+    if (node_subtype(cur->first) == SYNTAX_COMMA_AT) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Returns node itself when nothing splices. Otherwise the result is a new
+// list, neither node nor the spliced lists are modified, so function bodies
+// can be evaluated in place.
 Parse_Node *expand_splice(Parse_Node *node, Symbol_Table *env) {
-  // printf(" expanding splice in list %s\n", node->print().c_str());
-  
-  Parse_Node *ret = node;
-  Parse_Node *prev = nullptr;
+  if (!has_splice(node)) {
+    return node;
+  }
   
-  while (node->first != nullptr) {
-    // printf(" node: %s\n", node->first->print().c_str());
-    // printf(" type: %s\n", node->first->print_type().c_str());
-    // printf(" subtype: %s\n", node->first->print_subtype().c_str());
-    
-    if (node->first->subtype == SYNTAX_COMMA_AT) {
+  Parse_Node *ret = new Parse_Node{PARSE_NODE_LIST};
+  Parse_Node *tail = ret;
+  for (; !is_empty_list(node); node = node->next) {
+    if (node_subtype(node->first) == SYNTAX_COMMA_AT) {
       Parse_Node *elist = eval_parse_node(node->first->first, env);
       if (!is_list(elist)) {
 	throw runtimeError("Error: ,@ can only be used with list, "
-			   + node->first->first->print() +
+			   + print_node(node->first->first) +
 			   " is not a list\n");
       }
-      if (prev == nullptr) {
-	ret = elist;
-      } else {
-	prev->next = elist;
+      for (; !is_empty_list(elist); elist = elist->next) {
+	tail->first = elist->first;
+	tail->next = new Parse_Node{PARSE_NODE_LIST};
+	tail = tail->next;
       }
-      Parse_Node *cur = elist;
-      while (!is_empty_list(cur->next)) {
-	cur = cur->next;
+    } else {
+      tail->first = node->first;
+      tail->next = new Parse_Node{PARSE_NODE_LIST};
+      tail = tail->next;
+    }
+  }
+  return ret;
+}
+
+// A vector literal evaluates to a new vector of its evaluated elements,
+// ,@ splices the elements of a list or vector in.
+Parse_Node *eval_vector(Parse_Node *node, Symbol_Table *env) {
+  std::vector<Parse_Node *> &forms = vector_value(node);
+  Parse_Node *ret = make_vector();
+  std::vector<Parse_Node *> &elements = vector_value(ret);
+  elements.reserve(forms.size());
+  for (Parse_Node *form : forms) {
+    bool splice = node_subtype(form) == SYNTAX_COMMA_AT;
+    Parse_Node *value = eval_parse_node(splice ? form->first : form, env);
+    if (is_return(value)) {
+      return value;
+    }
+    if (!splice) {
+      elements.push_back(value);
+    } else if (is_vector(value)) {
+      std::vector<Parse_Node *> &spliced = vector_value(value);
+      elements.insert(elements.end(), spliced.begin(), spliced.end());
+    } else if (is_list(value)) {
+      for (; !is_empty_list(value); value = value->next) {
+	elements.push_back(value->first);
       }
-      cur->next = node->next;
-      prev = cur;
     } else {
-      prev = node;
+      throw runtimeError("Error: ,@ can only be used with a list or vector, "
+			 + print_node(form->first) + " is neither\n");
     }
-    node = node->next;
   }
-  // printf(" after expanding splice %s\n", ret->print().c_str());
   return ret;
 }
 
-// Splices will destroy the definition of functions and macros,
-// instead of returning a copy of the original structure each time
-// expand_splice is called, we only do it for function/macro applications
-Parse_Node *copy_node(Parse_Node *node) {
+static Parse_Node *copy_one(Parse_Node *node) {
+  if (is_fixnum(node)) {
+    return node;
+  }
   Parse_Node *new_node = new Parse_Node{};
   *new_node = *node;
-  if (new_node->first != nullptr) {    
-    new_node->first = copy_node(new_node->first);
-  }
-  if (new_node->next != nullptr) {
-    new_node->next = copy_node(new_node->next);
+  // side table entries belong to the original node, and the copy may be
+  // evaluated under other frames
+  new_node->flags &= ~(NODE_HAS_LOCATION | NODE_HAS_HEADER | NODE_GLOBAL_OPERATOR |
+		       NODE_HAS_CLOSURE | NODE_HAS_CHUNK | NODE_HAS_EXPANSION | NODE_HAS_TEMPLATE);
+  if (node->flags & NODE_HAS_LAMBDA_LIST) {
+    // parsed again by copy_node once the parameters are copied, the
+    // defaults point into the list
+    new_node->val.lambda_list = nullptr;
+  }
+  if (is_string(node)) {
+    new_node->val.str = new std::string(string_value(node));
+  }
+  if (is_bignum(node)) {
+    new_node->val.big = new Bignum(bignum_value(node));
+  }
+  if (is_vector(node)) {
+    new_node->val.vec = new std::vector<Parse_Node *>(vector_value(node));
+  }
+  if (is_hash(node)) {
+    new_node->val.hash = new Hash_Table(*node->val.hash);
+  }
+  if (is_array(node)) {
+    if (node->subtype == ARRAY_INT64) {
+      new_node->val.ints = new std::vector<int64_t>(*node->val.ints);
+    } else {
+      new_node->val.floats = new std::vector<double>(*node->val.floats);
+    }
+    gc_note_external(array_length(node) * sizeof(int64_t));
   }
   return new_node;
 }
 
+// Iterative, so long or deeply nested lists don't use up the native stack.
+// Every copy is linked into the result as soon as it's made, its first and
+// next are replaced by copies when it's taken off pending.
+Parse_Node *copy_node(Parse_Node *node) {
+  Parse_Node *ret = copy_one(node);
+  std::vector<Parse_Node *> pending = {ret};
+  std::vector<Parse_Node *> param_lists;
+  while (!pending.empty()) {
+    Parse_Node *cur = pending.back();
+    pending.pop_back();
+    if (is_fixnum(cur)) {
+      continue;
+    }
+    if (cur->flags & NODE_HAS_LAMBDA_LIST) {
+      param_lists.push_back(cur);
+    }
+    if (cur->type == PARSE_NODE_VECTOR) {
+      for (Parse_Node *&element : vector_value(cur)) {
+	element = copy_one(element);
+	pending.push_back(element);
+      }
+      continue;
+    }
+    if (cur->type == PARSE_NODE_HASH) {
+      // keys are copied by the table already
+      cur->val.hash->for_each([&pending](Parse_Node *key, Parse_Node *&value) {
+	value = copy_one(value);
+	pending.push_back(value);
+      });
+      continue;
+    }
+    if (cur->first != nullptr) {
+      cur->first = copy_one(cur->first);
+      pending.push_back(cur->first);
+    }
+    if (cur->next != nullptr) {
+      cur->next = copy_one(cur->next);
+      pending.push_back(cur->next);
+    }
+  }
+  // the original parsed, so the copy does too
+  for (Parse_Node *params : param_lists) {
+    params->val.lambda_list = new Lambda_List(parse_lambda_list(params, "function"));
+  }
+  return ret;
+}
+
 Parse_Node *builtin_copy(Parse_Node *args, Symbol_Table *env) {
   ARG_COUNT_EXACT("copy", 1);
 
@@ -159,187 +416,364 @@ Parse_Node *builtin_copy(Parse_Node *args, Symbol_Table *env) {
   return copy_node(earg);
 }
 
-Parse_Node *apply_fun(Parse_Node *fun, Parse_Node *node, Symbol_Table *env) {
-  // if is_fun we evaluate the arguments, if not is_fun then it's a macro so no argument evaluation
-  Parse_Node *fun_sym = node->first;
-  bool is_fun = (fun_sym->subtype == FUNCTION_NATIVE);
-  Symbol_Table *fun_env = new Symbol_Table(env);
-  
-  // printf("apply_fun: applying args to %s %s\n", is_fun ? "function" : "macro", fun->token.name.c_str());
-  
-  // bind given arguments to symbols in fun-params in the fun_env
-  Parse_Node *cur_param = fun->first;
-  Parse_Node *cur_arg = node->next;  
-  while (!is_empty_list(cur_param)) {
-    Parse_Node *param = cur_param->first;
-    Parse_Node *arg;
-
-    if (param->token.name == "&rest") {
-      cur_param = cur_param->next;
-      param = cur_param->first;
-
-      if (is_fun) {
-	Parse_Node *rest = new Parse_Node{PARSE_NODE_LIST};
-	Parse_Node *cur_rest = rest;
-	while (!is_empty_list(cur_arg)) {
-	  cur_rest->first = eval_parse_node(cur_arg->first, env);
-	  cur_rest->next = new Parse_Node{PARSE_NODE_LIST};
-	  cur_rest = cur_rest->next;
-	  cur_arg = cur_arg->next;
-	}
-        arg = rest;
-	
-      } else {
-        arg = cur_arg;
-      }
-      // cur_param = cur_param->next;
-      fun_env->table[param->token.name] = arg;
+// binds the arguments of node, a call to fun, in a new frame, returns
+// nullptr if evaluating an argument returned. Macros get their arguments
+// unevaluated.
+Symbol_Table *bind_arguments(Parse_Node *fun, Parse_Node *node, Symbol_Table *env) {
+  const Lambda_List *params = lambda_list(fun);
+  bool is_fun = (fun->subtype == FUNCTION_NATIVE);
+  Symbol_Table *fun_env = new Symbol_Table(fun->val.env);
+  Parse_Node *cur_arg = node->next;
+
+  for (uint32_t id : params->required) {
+    if (is_empty_list(cur_arg)) {
+      throw runtimeError("Error: Not enough arguments given to invocation of " +
+			 symbol_name(node->first) + "\n");
+    }
+    Parse_Node *arg = is_fun ? eval_parse_node(cur_arg->first, env) : cur_arg->first;
+    if (is_return(arg)) {
+      return nullptr;
+    }
+    fun_env->define(id, arg);
+    cur_arg = cur_arg->next;
+  }
+  if (params->is_fixed()) {
+    if (!is_empty_list(cur_arg)) {
+      throw runtimeError("Error: Too many arguments given to invocation of " +
+			 symbol_name(node->first) + "\n");
+    }
+    return fun_env;
+  }
 
-      // printf("apply_fun: arg is %s\n", arg->print().c_str());
-      while (!is_empty_list(cur_arg)) {
-	cur_arg = cur_arg->next;
-      }      
-      break;
-      
-    } else if (param->token.name == "&opt" || param->token.name == "&optional") {
-
-      cur_param = cur_param->next;
-      while (!is_empty_list(cur_param)) {
-	if (is_list(cur_param->first)) { // if the paramater has a default...
-	  Parse_Node *sym = cur_param->first->first;
-
-	  if (is_empty_list(cur_arg)) { // evaluate the default if no arg provided
-	    Parse_Node *val = cur_param->first->next->first;
-	    arg = eval_parse_node(val, env);
-	  } else { 
-	    arg = eval_parse_node(cur_arg->first, env);
-	    cur_arg = cur_arg->next;
-	  }
-	  fun_env->table[sym->token.name] = arg;
-	  
-	} else {
-	  Parse_Node *sym = cur_param->first;
-	  if (is_empty_list(cur_arg)) {
-	    fun_env->table[sym->token.name] = fal;
-	  } else {
-	    if (is_fun) {
-	      arg = eval_parse_node(cur_arg->first, env);
-	    } else {
-	      arg = cur_arg->first;
-	    }
-	    cur_arg = cur_arg->next;
-	    fun_env->table[sym->token.name] = arg;
-	  }
-	}
-	cur_param = cur_param->next;
-      }
-      continue;
-      
+  for (size_t i = 0; i < params->optional.size(); i++) {
+    Parse_Node *arg;
+    if (!is_empty_list(cur_arg)) {
+      arg = is_fun ? eval_parse_node(cur_arg->first, env) : cur_arg->first;
+      cur_arg = cur_arg->next;
+    } else if (params->defaults[i] != nullptr) {
+      // defaults see the parameters bound before them
+      arg = eval_parse_node(params->defaults[i], fun_env);
     } else {
-      if (is_empty_list(cur_arg)) {
-	throw runtimeError("Error: Not enough arguments given to invocation of " +
-			   fun_sym->token.name + "\n");
-      }      
-      if (is_fun) {
-	arg = eval_parse_node(cur_arg->first, env);
-      } else {
-	arg = cur_arg->first;
+      arg = fal;
+    }
+    if (is_return(arg)) {
+      return nullptr;
+    }
+    fun_env->define(params->optional[i], arg);
+  }
+
+  if (params->rest != Symbol_Table::EMPTY) {
+    Parse_Node *rest = cur_arg;
+    if (is_fun) {
+      rest = new Parse_Node{PARSE_NODE_LIST};
+      Parse_Node *cur_rest = rest;
+      for (; !is_empty_list(cur_arg); cur_arg = cur_arg->next) {
+	cur_rest->first = eval_parse_node(cur_arg->first, env);
+	if (is_return(cur_rest->first)) {
+	  return nullptr;
+	}
+	cur_rest->next = new Parse_Node{PARSE_NODE_LIST};
+	cur_rest = cur_rest->next;
       }
     }
-    
-    fun_env->table[param->token.name] = arg;
-    cur_param = cur_param->next;
-    cur_arg = cur_arg->next;
+    fun_env->define(params->rest, rest);
+    return fun_env;
   }
-  
+
   if (!is_empty_list(cur_arg)) {
     throw runtimeError("Error: Too many arguments given to invocation of " +
-		       fun_sym->token.name + "\n");
+		       symbol_name(node->first) + "\n");
   }
-  
-  // evaluate the body
-  // printf("apply_fun: evaling body %s %s\n", is_fun ? "function" : "macro", fun->token.name.c_str());
-  
-  Parse_Node *cur = copy_node(fun->next);
-  
-  Parse_Node *ret;
-  while (!is_empty_list(cur)) {
-    try {
-      ret = eval_parse_node(cur->first, fun_env);
-    } catch (returnException e) {
-      return e.ret;
+  return fun_env;
+}
+
+Parse_Node *apply_fun(Parse_Node *fun, Parse_Node *node, Symbol_Table *env) {
+  Symbol_Table *fun_env = bind_arguments(fun, node, env);
+  if (fun_env == nullptr) {
+    return return_signal;
+  }
+  return run_body(fun, fun_env);
+}
+
+// Value builtin calls with more arguments than fit in the array on the
+// stack keep them here. The calls nest, each one uses the entries past its
+// base and truncates back to it.
+static std::vector<Parse_Node *> value_args;
+static const uint32_t STACK_VALUE_ARGS = 8;
+
+struct Value_Args_Base {
+  size_t base = value_args.size();
+  ~Value_Args_Base() { value_args.resize(base); }
+};
+
+Parse_Node *apply_builtin(Parse_Node *builtin, Parse_Node *args, Symbol_Table *env) {
+  if (!(builtin->flags & NODE_VALUE_BUILTIN)) {
+    return builtin->val.func(args, env);
+  }
+  Parse_Node *values[STACK_VALUE_ARGS];
+  uint32_t argc = 0;
+  for (; args->first != nullptr && argc < STACK_VALUE_ARGS; args = args->next) {
+    values[argc] = eval_parse_node(args->first, env);
+    if (is_return(values[argc])) {
+      return return_signal;
     }
-    cur = cur->next;    
+    argc++;
+  }
+  if (args->first == nullptr) {
+    return call_values(builtin, values, argc);
   }
 
-  // printf("apply_fun: done evaling body %s %s\n", is_fun ? "function" : "macro", fun->token.name.c_str());
-  return ret;
+  Value_Args_Base frame;
+  value_args.insert(value_args.end(), values, values + argc);
+  for (; !is_empty_list(args); args = args->next) {
+    Parse_Node *value = eval_parse_node(args->first, env);
+    if (is_return(value)) {
+      return return_signal;
+    }
+    value_args.push_back(value);
+  }
+  return call_values(builtin, value_args.data() + frame.base, value_args.size() - frame.base);
 }
 
-Parse_Node *eval_backtick(Parse_Node *node, Symbol_Table *env) {
-  if (node->subtype == SYNTAX_COMMA) {
-    return eval_parse_node(node->first, env);
+void throw_arity_error(Parse_Node *builtin, uint32_t argc) {
+  const Value_Builtin *b = builtin->val.builtin;
+  std::string expected;
+  if (b->min_args == b->max_args) {
+    expected = "exactly " + std::to_string(b->min_args) +
+      (b->min_args == 1 ? " argument" : " arguments");
+  } else if (b->max_args == UINT32_MAX) {
+    expected = std::to_string(b->min_args) + "+ arguments";
+  } else {
+    expected = std::to_string(b->min_args) + " to " + std::to_string(b->max_args) + " arguments";
   }
-  
-  if (is_list(node)) {
-    node = eval_backtick_list(node, env);
+  throw runtimeError("Error: " + symbol_name(builtin) + " takes " + expected +
+		     ", received " + std::to_string(argc) + "\n");
+}
+
+// The trampoline: a call in tail position binds its frame and comes back
+// here as tail_call_signal, so tail recursion doesn't grow the C++ stack.
+Parse_Node *run_body(Parse_Node *fun, Symbol_Table *fun_env) {
+  Call_Depth depth;
+  while (true) {
+    Parse_Node *ret;
+    if (fun->subtype == FUNCTION_NATIVE && engine == ENGINE_CLOSURE) {
+      ret = closure_run_body(fun, fun_env);
+    } else {
+      ret = eval_body(fun->next, fun_env);
+    }
+    if (is_return(ret)) {
+      return take_return();
+    }
+    if (!is_tail_call(ret)) {
+      return ret;
+    }
+    fun = tail_fun;
+    fun_env = tail_env;
+    tail_fun = nullptr;
+    tail_env = nullptr;
   }
-  return node;
 }
 
-Parse_Node *eval_backtick_list(Parse_Node *node, Symbol_Table *env) {
-  Parse_Node *first = node;
-  node = expand_splice(node, env);  
-  Parse_Node *ret = new Parse_Node{PARSE_NODE_LIST};
-  Parse_Node *list = ret;
-  while (!is_empty_list(node)) {
-    list->first = eval_backtick(node->first, env);
-    list->next = new Parse_Node{PARSE_NODE_LIST};
-    list = list->next;
-    node = node->next;
+// the last form is evaluated in tail position
+Parse_Node *eval_body(Parse_Node *forms, Symbol_Table *env) {
+  if (is_empty_list(forms)) {
+    return new Parse_Node{PARSE_NODE_LIST};
   }
-  return ret;
+  while (!is_empty_list(forms->next)) {
+    Parse_Node *ret = eval_parse_node(forms->first, env);
+    if (is_return(ret)) {
+      return ret;
+    }
+    forms = forms->next;
+  }
+  return eval_tail(forms->first, env);
 }
 
-Parse_Node *expand_eval_macro(Parse_Node *macro, Parse_Node *node, Symbol_Table *env) {
-  Parse_Node *expand;
-  try {
-    expand = apply_fun(macro, node, env);
-  } catch (returnException e) {
-    return e.ret;
+Parse_Node *signal_tail_call(Parse_Node *fun, Symbol_Table *fun_env) {
+  tail_fun = fun;
+  tail_env = fun_env;
+  return tail_call_signal;
+}
+
+static Parse_Node *eval_tail_if(Parse_Node *args, Symbol_Table *env) {
+  Parse_Node *condition = eval_parse_node(args->first, env);
+  if (is_return(condition)) {
+    return condition;
   }
-  
-  Parse_Node *ret;
-  
-  // nah...
+  if (bool_value(condition)) {
+    return eval_tail(args->next->first, env);
+  }
+  if (is_empty_list(args->next->next)) {
+    return new Parse_Node{PARSE_NODE_LIST};
+  }
+  return eval_tail(args->next->next->first, env);
+}
+
+// Like eval_parse_node, except that a call to a native function binds its
+// arguments and returns tail_call_signal for run_body to finish. if, progn,
+// let and macro expansions pass the tail position on to their last form.
+Parse_Node *eval_tail(Parse_Node *node, Symbol_Table *env) {
+  if (node_type(node) != PARSE_NODE_LIST || is_empty_list(node) ||
+      !is_sym(node->first) || has_splice(node)) {
+    return eval_parse_node(node, env);
+  }
+  Parse_Node *func = call_operator(node, env);
+  if (func == nullptr || node_type(func) != PARSE_NODE_FUNCTION) {
+    return eval_parse_node(node, env);
+  }
+  Parse_Node *args = node->next;
+
   try {
-    ret = eval_parse_node(expand, env);  
-  } catch (returnException e) {
-    return e.ret;
-  }  
-  
-  return ret;
+    switch (func->subtype) {
+    case FUNCTION_NATIVE: {
+      Symbol_Table *fun_env = bind_arguments(func, node, env);
+      if (fun_env == nullptr) {
+	return return_signal;
+      }
+      return signal_tail_call(func, fun_env);
+    }
+    case FUNCTION_MACRO:
+      return eval_tail(expand_macro(func, node, env), env);
+
+    case FUNCTION_BUILTIN: {
+      auto builtin = forms_func(func);
+      int nargs = args->length();
+      if (builtin == builtin_if && (nargs == 2 || nargs == 3)) {
+	return eval_tail_if(args, env);
+      }
+      if (builtin == builtin_progn && nargs >= 1) {
+	return eval_body(args, env);
+      }
+      if (builtin == builtin_let && nargs >= 2) {
+	Symbol_Table *let_env = bind_let(args, env);
+	if (let_env == nullptr) {
+	  return return_signal;
+	}
+	return eval_body(args->next, let_env);
+      }
+      return eval_parse_node(node, env);
+    }
+    default:
+      return eval_parse_node(node, env);
+    }
+  } catch (runtimeError &e) {
+    return error_value(e.what());
+  }
+}
+
+// Expansions are kept per call site. An entry is used only while the
+// operator is still bound to the same macro, no defmacro has run since it
+// was made, a macro body can call other macros, and the call still has the
+// same arguments, a form can be changed in place with set. The macro, the
+// expansion and a list of the arguments live in three slots of
+// expansion_roots so the collector keeps them.
+struct Macro_Expansion {
+  uint32_t slot;
+  uint32_t epoch;
+};
+
+static std::unordered_map<Parse_Node *, Macro_Expansion> macro_expansions;
+static std::vector<Parse_Node *> expansion_roots;
+static std::vector<uint32_t> free_expansion_slots;
+static uint32_t macro_epoch = 0;
+
+uint32_t current_macro_epoch() {
+  return macro_epoch;
+}
+
+// a new list holding the same argument nodes
+static Parse_Node *argument_list(Parse_Node *args) {
+  Parse_Node *list = new Parse_Node{PARSE_NODE_LIST};
+  Parse_Node *cur = list;
+  for (; !is_empty_list(args); args = args->next) {
+    cur->first = args->first;
+    cur->next = new Parse_Node{PARSE_NODE_LIST};
+    cur = cur->next;
+  }
+  return list;
+}
+
+static bool same_arguments(Parse_Node *args, Parse_Node *list) {
+  for (; !is_empty_list(args); args = args->next, list = list->next) {
+    if (args->first != list->first) {
+      return false;
+    }
+  }
+  return is_empty_list(list);
+}
+
+Parse_Node *expand_macro(Parse_Node *macro, Parse_Node *node, Symbol_Table *env) {
+  auto it = macro_expansions.find(node);
+  if (it != macro_expansions.end() && it->second.epoch == macro_epoch &&
+      expansion_roots[it->second.slot] == macro &&
+      same_arguments(node->next, expansion_roots[it->second.slot + 2])) {
+    return expansion_roots[it->second.slot + 1];
+  }
+
+  Parse_Node *expansion = apply_fun(macro, node, env);
+  if (is_error(expansion) || is_return(expansion)) {
+    return expansion;
+  }
+  Parse_Node *args = argument_list(node->next);
+  // apply_fun and argument_list can collect, look the site up again
+  it = macro_expansions.find(node);
+  uint32_t slot;
+  if (it != macro_expansions.end()) {
+    slot = it->second.slot;
+  } else if (!free_expansion_slots.empty()) {
+    slot = free_expansion_slots.back();
+    free_expansion_slots.pop_back();
+  } else {
+    slot = expansion_roots.size();
+    expansion_roots.resize(slot + 3);
+  }
+  expansion_roots[slot] = macro;
+  expansion_roots[slot + 1] = expansion;
+  expansion_roots[slot + 2] = args;
+  macro_expansions[node] = {slot, macro_epoch};
+  node->flags |= NODE_HAS_EXPANSION;
+  return expansion;
+}
+
+void macro_forget(Parse_Node *node) {
+  auto it = macro_expansions.find(node);
+  if (it == macro_expansions.end()) {
+    return;
+  }
+  uint32_t slot = it->second.slot;
+  expansion_roots[slot] = nullptr;
+  expansion_roots[slot + 1] = nullptr;
+  expansion_roots[slot + 2] = nullptr;
+  free_expansion_slots.push_back(slot);
+  macro_expansions.erase(it);
+}
+
+// a return in the expansion belongs to the enclosing function, the signal
+// is passed up
+Parse_Node *expand_eval_macro(Parse_Node *macro, Parse_Node *node, Symbol_Table *env) {
+  Parse_Node *expand = expand_macro(macro, node, env);
+  return eval_parse_node(expand, env);
 }
 
 Parse_Node *builtin_inspect_macro(Parse_Node *args, Symbol_Table *env) {
   Parse_Node *sym = args->first;
-  printf("\n\nmacro: %s\n", sym->print().c_str());
+  printf("\n\nmacro: %s\n", print_node(sym).c_str());
   if (!is_sym(sym)) {
     throw runtimeError("Error: inspect-macro requires a symbol for its argument\n");
   }
 
-  Parse_Node *macro = env->lookup(sym->token.name);
+  Parse_Node *macro = env->lookup(sym->aux);
   if (macro == nullptr) {
-    throw runtimeError("Error: could not find macro named " + macro->print() + "\n");
+    throw runtimeError("Error: could not find macro named " + print_node(macro) + "\n");
   }
   
-  if (macro->subtype != FUNCTION_MACRO) {
+  if (node_subtype(macro) != FUNCTION_MACRO) {
     throw runtimeError("Error: inspect-macro requires a macro for its argument\n");
   }
   
-  // printf("Inspecting macro %s\n", macro->print().c_str());
-  // printf("    params: %s\n", macro->first->print().c_str());
-  // printf("      body: %s\n", macro->next->print().c_str());
+  // printf("Inspecting macro %s\n", print_node(macro).c_str());
+  // printf("    params: %s\n", print_node(macro->first).c_str());
+  // printf("      body: %s\n", print_node(macro->next).c_str());
   
   return new Parse_Node{PARSE_NODE_LIST};
 }
@@ -349,14 +783,14 @@ Parse_Node *builtin_expand(Parse_Node *args, Symbol_Table *env) {
 
   Parse_Node *macro_sym = args->first;
   if (!is_sym(macro_sym)) {
-    throw runtimeError("Error: invalid expand call, " + macro_sym->print() + " is not a symbol\n" );
+    throw runtimeError("Error: invalid expand call, " + print_node(macro_sym) + " is not a symbol\n" );
   }
 
-  Parse_Node *macro = env->lookup(macro_sym->token.name);
-  if (macro == nullptr || macro->subtype != FUNCTION_MACRO) {
-    throw runtimeError("Error: could not find macro named " + macro_sym->print() + "\n");
+  Parse_Node *macro = env->lookup(macro_sym->aux);
+  if (macro == nullptr || node_subtype(macro) != FUNCTION_MACRO) {
+    throw runtimeError("Error: could not find macro named " + print_node(macro_sym) + "\n");
   }
-  return apply_fun(macro, args, env);
+  return expand_macro(macro, args, env);
 }
 
 Parse_Node *builtin_quote(Parse_Node *args, Symbol_Table *env) {
@@ -364,6 +798,76 @@ Parse_Node *builtin_quote(Parse_Node *args, Symbol_Table *env) {
   return args->first;
 }
 
+// Lambda lists are required parameters, then optionally &opt (or
+// &optional) and one or more parameters that can be (name default), then
+// optionally &rest and one parameter.
+static Lambda_List parse_lambda_list(Parse_Node *param_list, const std::string &obj_type) {
+  Lambda_List params;
+  bool optional = false;
+  for (; !is_empty_list(param_list); param_list = param_list->next) {
+    Parse_Node *param = param_list->first;
+
+    if (optional && is_list(param)) {
+      if (param->length() != 2) {
+	throw runtimeError("Error: two items required in lists after &optional\n"
+			   "       A symbol, and a default value\n");
+      }
+      if (!is_sym(param->first)) {
+	throw runtimeError("Error: first item in parameter default list " +
+			   print_node(param) +
+			   + " is not a symbol\n");
+      }
+      params.optional.push_back(param->first->aux);
+      params.defaults.push_back(param->next->first);
+      continue;
+    }
+
+    if (!is_sym(param)) {
+      throw runtimeError("Error: " + obj_type
+			  +
+			 " parameter `" + print_node(param) +
+			 "` is not a symbol\n");
+    }
+
+    if (param->aux == sym_rest) {
+      param_list = param_list->next;
+      param = param_list->first;
+      if (param == nullptr) {
+	throw runtimeError("Error: paramater required after &rest\n");
+      }
+      if (!is_sym(param)) {
+	throw runtimeError("Error: " + obj_type + " parameter `" + print_node(param) +
+			   "` is not a symbol\n");
+      }
+      if (param_list->next->first != nullptr) {
+	throw runtimeError("Error: there can only be one parameter after &rest\n");
+      }
+      params.rest = param->aux;
+      break;
+    }
+
+    if (param->aux == sym_opt || param->aux == sym_optional) {
+      if (optional) {
+	throw runtimeError("Error: &optional can only be given once\n");
+      }
+      Parse_Node *next = param_list->next->first;
+      if (next == nullptr || (is_sym(next) && next->aux == sym_rest)) {
+	throw runtimeError("Error: one or more paramater required after &optional\n");
+      }
+      optional = true;
+      continue;
+    }
+
+    if (optional) {
+      params.optional.push_back(param->aux);
+      params.defaults.push_back(nullptr);
+    } else {
+      params.required.push_back(param->aux);
+    }
+  }
+  return params;
+}
+
 Parse_Node *build_function(Parse_Node *args, Symbol_Table *env, bool is_fun) {
   std::string obj_type = (is_fun ? "function" : "macro");
   std::string abbrev = (is_fun ? "func" : "macro");
@@ -388,57 +892,12 @@ Parse_Node *build_function(Parse_Node *args, Symbol_Table *env, bool is_fun) {
     throw runtimeError("Error: argument " + abbrev + "-params requires a list\n");
   }
 
-  Parse_Node *param_list = fun_params;
-  while (!is_empty_list(param_list)) {
-    Parse_Node *param = param_list->first;
-
-    if (!is_sym(param)) {
-      throw runtimeError("Error: " + obj_type
-			  +
-			 " parameter `" + param->print() +
-			 "` is not a symbol\n");
-    }
-    
-    if (param->token.name == "&rest") {
-      param_list = param_list->next;
-      param = param_list->first;
-      if (param == nullptr) {
-	throw runtimeError("Error: paramater required after &rest\n");
-      }
-
-      param_list = param_list->next;
-      if (param_list->first != nullptr) {
-	throw runtimeError("Error: there can only be one parameter after &rest\n");
-      }
-      continue;
-    }
-
-    if (param->token.name == "&opt" || param->token.name == "&optional") {
-      param_list = param_list->next;
-      param = param_list->first;
-      if (param == nullptr) {
-	throw runtimeError("Error: one or more paramater required after &optional\n");
-      }
-
-      param_list = param_list->next;
-      while (!is_empty_list(param_list)) {
-	param = param_list->first;
-	if (is_list(param)) {
-	  if (param->length() != 2) {
-	    throw runtimeError("Error: two items required in lists after &optional\n"
-	                       "       A symbol, and a default value\n");
-	  }
-	  if (!is_sym(param->first)) {
-	    throw runtimeError("Error: first item in parameter default list " +
-			       param->print() +
-			       + " is not a symbol\n");
-	  }
-	}
-	param_list = param_list->next;
-      }
-      continue;
-    } 
-    param_list = param_list->next;
+  if (!(fun_params->flags & NODE_HAS_LAMBDA_LIST)) {
+    Lambda_List *params = new Lambda_List(parse_lambda_list(fun_params, obj_type));
+    fun_params->val.lambda_list = params;
+    // the list may have been a call site, its cached operator is gone
+    fun_params->aux = 0;
+    fun_params->flags |= NODE_HAS_LAMBDA_LIST;
   }
 
   Parse_Node *new_fun = new Parse_Node{PARSE_NODE_FUNCTION};
@@ -447,16 +906,19 @@ Parse_Node *build_function(Parse_Node *args, Symbol_Table *env, bool is_fun) {
   } else {
     new_fun->subtype = FUNCTION_MACRO;
   }
-  new_fun->token = fun_name->token;
+  new_fun->aux = fun_name->aux;
+  new_fun->val.env = env;
   new_fun->first = fun_params;
   new_fun->next = args->next->next;
 
   // printf("defining function %s: %s, %s\n",
-  // 	 fun_name->token.name.c_str(),
-  // 	 new_fun->first->print().c_str(),
-  // 	 new_fun->next->print().c_str());
+  // 	 symbol_name(fun_name).c_str(),
+  // 	 print_node(new_fun->first).c_str(),
+  // 	 print_node(new_fun->next).c_str());
   
-  env->table[fun_name->token.name] = new_fun;
+  global_env->define(fun_name->aux, new_fun);
+  definition_epoch++;
+  resolve_function(new_fun, env);
   return new_fun;
 }
 
@@ -465,11 +927,11 @@ Parse_Node *builtin_defun(Parse_Node *args, Symbol_Table *env) {
 }
 
 Parse_Node *builtin_return(Parse_Node *args, Symbol_Table *env) {
-  Parse_Node *earg = eval_parse_node(args->first, env);
-  throw returnException(earg);
+  return signal_return(eval_parse_node(args->first, env));
 }
 
 Parse_Node *builtin_defmacro(Parse_Node *args, Symbol_Table *env) {
+  macro_epoch++;
   return build_function(args, env, false);
 }
 
@@ -486,8 +948,8 @@ Parse_Node *builtin_defsym(Parse_Node *args, Symbol_Table *env) {
   }
 
   Parse_Node *val = eval_parse_node(args->next->first, env);
-  env->table[sym->token.name] = val;
-  Parse_Node *inserted =   env->table[sym->token.name];  
+  global_env->define(sym->aux, val);
+  definition_epoch++;
   return sym;
 }
 
@@ -503,44 +965,81 @@ Parse_Node *builtin_progn(Parse_Node *args, Symbol_Table *env) {
   
   while (!is_empty_list(cur)) {
     ret = eval_parse_node(cur->first, env);
+    if (is_return(ret)) {
+      return ret;
+    }
     cur = cur->next;
   }
   return ret;
 }
 
-Parse_Node *builtin_list(Parse_Node *args, Symbol_Table *env) {
+Parse_Node *builtin_list(Parse_Node **args, uint32_t argc) {
   Parse_Node *list = new Parse_Node{PARSE_NODE_LIST};
   Parse_Node *cur = list;
-  Parse_Node *arg = args;
-  while (!is_empty_list(arg)) {
-    cur->first = eval_parse_node(arg->first, env);
+  for (uint32_t i = 0; i < argc; i++) {
+    cur->first = args[i];
     cur->next = new Parse_Node{PARSE_NODE_LIST};
     cur = cur->next;
-    arg = arg->next;
   }
   return list;
 }
 
+Parse_Node *builtin_vector(Parse_Node **args, uint32_t argc) {
+  Parse_Node *vec = make_vector();
+  vector_value(vec).assign(args, args + argc);
+  return vec;
+}
+
+// (make-vector size [init]), init defaults to the empty list
+Parse_Node *builtin_make_vector(Parse_Node **args, uint32_t argc) {
+  if (!is_integer(args[0]) || integer_value(args[0]) < 0) {
+    throw runtimeError("Error: make-vector size " + print_node(args[0]) +
+		       " is not a non-negative integer\n");
+  }
+  Parse_Node *init = argc == 2 ? args[1] : new Parse_Node{PARSE_NODE_LIST};
+  Parse_Node *vec = make_vector();
+  vector_value(vec).assign(integer_value(args[0]), init);
+  return vec;
+}
+
+// Vectors and packed arrays are indexed in place, first, last and nth leave
+// the index of the element in aux for set.
+static bool is_indexed(Parse_Node *seq) {
+  return is_vector(seq) || is_array(seq);
+}
+
+static size_t indexed_length(Parse_Node *seq) {
+  return is_vector(seq) ? vector_value(seq).size() : array_length(seq);
+}
+
+static Parse_Node *indexed_element(Parse_Node *seq, size_t index) {
+  return is_vector(seq) ? vector_value(seq)[index] : array_element(seq, index);
+}
+
 Parse_Node *set_first(Parse_Node *args, Symbol_Table *env) {
   ARG_COUNT_EXACT("first", 1);
 
   Parse_Node *earg = eval_parse_node(args->first, env);
   
-  if (!is_list(earg) && !is_string(earg)) {
-    throw runtimeError("Error: argument to first  " + earg->print() + " is not a sequence\n");
+  if (!is_sequence(earg)) {
+    throw runtimeError("Error: argument to first  " + print_node(earg) + " is not a sequence\n");
+  }
+  if (is_indexed(earg)) {
+    earg->aux = 0;
   }
   return earg;
 }
 
 Parse_Node *builtin_first(Parse_Node *args, Symbol_Table *env) {
   Parse_Node *ret = set_first(args, env);
+  if (is_indexed(ret)) {
+    return indexed_length(ret) == 0 ? ret : indexed_element(ret, 0);
+  }
   if (ret == nullptr || ret->first == nullptr) {
     return ret;    
   }
   if (is_string(ret)) {
-    Parse_Node *n = new Parse_Node{PARSE_NODE_LITERAL, LITERAL_STRING};
-    n->token.name = ret->token.name[0];
-    return n;
+    return make_string(string_value(ret).substr(0, 1));
   }
   return ret->first;
 }
@@ -549,8 +1048,12 @@ Parse_Node *set_last(Parse_Node *args, Symbol_Table *env) {
   ARG_COUNT_EXACT("last", 1);
 
   Parse_Node *earg = eval_parse_node(args->first, env);
-  if (!is_list(earg) && !is_string(earg)) {
-    throw runtimeError("Error: argument to last " + earg->print() + " is not a sequence\n");
+  if (!is_sequence(earg)) {
+    throw runtimeError("Error: argument to last " + print_node(earg) + " is not a sequence\n");
+  }
+  if (is_indexed(earg)) {
+    earg->aux = indexed_length(earg) - 1;
+    return earg;
   }
   if (is_empty_list(earg) || is_string(earg)) {
     return earg;
@@ -567,14 +1070,15 @@ Parse_Node *set_last(Parse_Node *args, Symbol_Table *env) {
 
 Parse_Node *builtin_last(Parse_Node *args, Symbol_Table *env) {
   Parse_Node *ret = set_last(args, env);
+  if (is_indexed(ret)) {
+    return indexed_length(ret) == 0 ? ret : indexed_element(ret, ret->aux);
+  }
   if (ret == nullptr || is_empty_list(ret)) {
     return ret;  
   }
   if (is_string(ret)) {
-    Parse_Node *n = new Parse_Node{PARSE_NODE_LITERAL, LITERAL_STRING};
-    int l = ret->token.name.length() - 1;
-    n->token.name = ret->token.name[l];
-    return n;
+    int l = string_value(ret).length() - 1;
+    return make_string(string_value(ret).substr(l, 1));
   }  
   return ret->first;
 }
@@ -584,23 +1088,34 @@ Parse_Node *set_nth(Parse_Node *args, Symbol_Table *env) {
   
   Parse_Node *n = eval_parse_node(args->first, env);
   if (!is_integer(n)) {
-    throw runtimeError("Error: argument " + n->print() + " not an integer\n");
+    throw runtimeError("Error: argument " + print_node(n) + " not an integer\n");
   }
   
   Parse_Node *seq = eval_parse_node(args->next->first, env);
   if (!is_sequence(seq)) {
-    throw runtimeError("Error: argument " + seq->print() + " not a sequence\n");
+    throw runtimeError("Error: argument " + print_node(seq) + " not a sequence\n");
   }
 
-  int nth = n->val.u64;
+  int nth = integer_value(n);
+
+  if (is_indexed(seq)) {
+    size_t size = indexed_length(seq);
+    if (nth < 1 || (size_t)nth > size) {
+      throw runtimeError("Error: index " + std::to_string(nth) + " is out of range for " +
+			 (is_vector(seq) ? "a vector" : "an array") +
+			 " of length " + std::to_string(size) + "\n");
+    }
+    seq->aux = nth - 1;
+    return seq;
+  }
 
   if (is_string(seq)) {
     --nth;
-    int len = seq->token.name.length();
+    int len = string_value(seq).length();
     if (nth >= len) {
       nth = len - 1;
     }
-    seq->val.u64 = nth;  //I won't tell anyone if you won't
+    seq->aux = nth;  //I won't tell anyone if you won't
     return seq;
   }
   
@@ -619,13 +1134,14 @@ Parse_Node *set_nth(Parse_Node *args, Symbol_Table *env) {
 
 Parse_Node *builtin_nth(Parse_Node *args, Symbol_Table *env) {
   Parse_Node *ret = set_nth(args, env);
+  if (is_indexed(ret)) {
+    return indexed_element(ret, ret->aux);
+  }
   if (ret == nullptr || ret->first == nullptr || ret->subtype == LITERAL_STRING) {
     return ret;  
   }
   if (is_string(ret)) {
-    Parse_Node *n = new Parse_Node{PARSE_NODE_LITERAL, LITERAL_STRING};
-    n->token.name = ret->token.name[ret->val.u64];
-    return n;
+    return make_string(string_value(ret).substr(ret->aux, 1));
   }  
   return ret->first;  
 }
@@ -635,43 +1151,44 @@ Parse_Node *builtin_pop(Parse_Node *args, Symbol_Table *env) {
 
   Parse_Node *earg = eval_parse_node(args->first, env);
   if (!is_list(earg)) {
-    throw runtimeError("Error: argument " + earg->print() + " not a list\n");
+    throw runtimeError("Error: argument " + print_node(earg) + " not a list\n");
   }
   if (is_empty_list(earg)) {
     return earg;
   }
-  return earg->next;
+  return list_pop(earg);
 }
 
-Parse_Node *builtin_push(Parse_Node *args, Symbol_Table *env) {
-  ARG_COUNT_EXACT("push", 2);
-  Parse_Node *earg2 = eval_parse_node(args->next->first, env);
-  if (!is_list(earg2)) {
-    throw runtimeError("Error: argument " + earg2->print() + " not a list\n");
+// a vector gives a new vector, like a list the one pushed onto is unchanged
+Parse_Node *builtin_push(Parse_Node **args, uint32_t argc) {
+  if (is_vector(args[1])) {
+    std::vector<Parse_Node *> &elements = vector_value(args[1]);
+    Parse_Node *ret = make_vector();
+    vector_value(ret).reserve(elements.size() + 1);
+    vector_value(ret).push_back(args[0]);
+    vector_value(ret).insert(vector_value(ret).end(), elements.begin(), elements.end());
+    return ret;
   }
-  Parse_Node *earg1 = eval_parse_node(args->first, env);
-  Parse_Node *ret = new Parse_Node{PARSE_NODE_LIST};
-  ret->first = earg1;
-  ret->next = earg2;
-  return ret;
+  if (!is_list(args[1])) {
+    throw runtimeError("Error: argument " + print_node(args[1]) + " not a list\n");
+  }
+  return list_push(args[0], args[1]);
 }
 
 Parse_Node *builtin_append(Parse_Node *args, Symbol_Table *env) {
   ARG_COUNT_EXACT("append", 2);
 
   Parse_Node *list = eval_parse_node(args->next->first, env);
-  Parse_Node *end = list;
-  if (!is_list(list)) {
-    throw runtimeError("Error: first argument to append, " + list->print() + ", is not a list\n");
+  if (is_vector(list)) {
+    Parse_Node *earg1 = eval_parse_node(args->first, env);
+    vector_value(list).push_back(earg1);
+    return list;
   }
-
-  while (!is_empty_list(end)) {
-    end = end->next;
+  if (!is_list(list)) {
+    throw runtimeError("Error: first argument to append, " + print_node(list) + ", is not a list\n");
   }
 
-  Parse_Node *earg1 = eval_parse_node(args->first, env);
-  end->first = earg1;
-  end->next = new Parse_Node{PARSE_NODE_LIST};
+  list_append(list, eval_parse_node(args->first, env));
   return list;
 }
 
@@ -681,46 +1198,40 @@ Parse_Node *builtin_string_concatenate(Parse_Node *args, Symbol_Table *env) {
   while (!is_empty_list(args)) {
     Parse_Node *earg = eval_parse_node(args->first, env);
     if (is_string(earg)) {
-      con += earg->token.name;
+      con += string_value(earg);
     } else {
-      con += earg->print();
+      con += print_node(earg);
     }
     args = args->next;
   }
-  Parse_Node *ret = new Parse_Node{PARSE_NODE_LITERAL, LITERAL_STRING};
-  ret->token.name = con;
-  return ret;
+  return make_string(con);
 }
 
-Parse_Node *builtin_length(Parse_Node *args, Symbol_Table *env) {
-  ARG_COUNT_EXACT("length", 1);
-  
-  Parse_Node *list = eval_parse_node(args->first, env);
-  if (list->type != PARSE_NODE_LIST) {
-    throw runtimeError("Error: argument to length is not a list\n");
+Parse_Node *builtin_length(Parse_Node **args, uint32_t argc) {
+  if (is_indexed(args[0])) {
+    return make_integer(indexed_length(args[0]));
   }
-
-  Parse_Node *ret = new Parse_Node{PARSE_NODE_LITERAL, LITERAL_INTEGER};
-  ret->val.u64 = list->length();
-  return ret;
+  if (!is_list(args[0])) {
+    throw runtimeError("Error: argument to length is not a list, vector or array\n");
+  }
+  return make_integer(args[0]->length());
 }
 
 Parse_Node *builtin_empty_q(Parse_Node *args, Symbol_Table *env) {
   ARG_COUNT_EXACT("empty?", 1);
 
   Parse_Node *earg = eval_parse_node(args->first, env);
-  
+  if (is_indexed(earg)) {
+    return indexed_length(earg) == 0 ? tru : fal;
+  }
   if (!is_list(earg) || !is_empty_list(earg)) {
     return fal;
   }
   return tru;
 }
 
-Parse_Node *builtin_let(Parse_Node *args, Symbol_Table *env) {
-  if (is_empty_list(args)) {
-    throw runtimeError("Error: not enough arguments in `let`\n");
-  }
-
+// the frame of a let with its bindings evaluated, nullptr if a value returned
+Symbol_Table *bind_let(Parse_Node *args, Symbol_Table *env) {
   Symbol_Table *let_env = new Symbol_Table(env);
   Parse_Node *defs = args->first;
 
@@ -733,24 +1244,27 @@ Parse_Node *builtin_let(Parse_Node *args, Symbol_Table *env) {
 
     Parse_Node *sym;
     Parse_Node *val;      
-    switch (let_form->type) {
+    switch (node_type(let_form)) {
     case PARSE_NODE_LIST: {
 
       int lfs = let_form->length();
       if (lfs != 2 && lfs != 1) {
-	throw runtimeError("Error: invalid let binding: " + let_form->print() + "\n");
+	throw runtimeError("Error: invalid let binding: " + print_node(let_form) + "\n");
       }
      
       sym = let_form->first;
 
       if (!is_sym(sym)) {
-	throw runtimeError("Error: invalid let binding: `" + sym->print() + "` is not a symbol\n");
+	throw runtimeError("Error: invalid let binding: `" + print_node(sym) + "` is not a symbol\n");
       }
       
       if (lfs == 1) {
 	val = new Parse_Node{PARSE_NODE_LIST};
       } else {
 	val = eval_parse_node(let_form->next->first, let_env);
+	if (is_return(val)) {
+	  return nullptr;
+	}
       }
       break;
     }
@@ -760,13 +1274,25 @@ Parse_Node *builtin_let(Parse_Node *args, Symbol_Table *env) {
       break;
     }
     default: {
-      throw runtimeError("Error: invalid let binding: " + let_form->print() + "\n");
+      throw runtimeError("Error: invalid let binding: " + print_node(let_form) + "\n");
       break;
     }
     }
-    let_env->table[sym->token.name] = val;
+    let_env->define(sym->aux, val);
     defs = defs->next;
   }
+  return let_env;
+}
+
+Parse_Node *builtin_let(Parse_Node *args, Symbol_Table *env) {
+  if (is_empty_list(args)) {
+    throw runtimeError("Error: not enough arguments in `let`\n");
+  }
+
+  Symbol_Table *let_env = bind_let(args, env);
+  if (let_env == nullptr) {
+    return return_signal;
+  }
 
   if (is_empty_list(args->next)) {
     return new Parse_Node{PARSE_NODE_LIST};
@@ -776,9 +1302,12 @@ Parse_Node *builtin_let(Parse_Node *args, Symbol_Table *env) {
   Parse_Node *cur = args->next;
   // printf("start evaling let body\n");
   while (!is_empty_list(cur)) {
-    // printf("      evaling in let body %s\n", cur->first->print().c_str());    
+    // printf("      evaling in let body %s\n", print_node(cur->first).c_str());    
     ret = eval_parse_node(cur->first, let_env);
-    // printf("      evaled to %s\n", ret->print().c_str());
+    // printf("      evaled to %s\n", print_node(ret).c_str());
+    if (is_return(ret)) {
+      return ret;
+    }
     cur = cur->next;
   }
   // printf("done evaling let body\n");
@@ -793,6 +1322,9 @@ Parse_Node *builtin_if(Parse_Node *args, Symbol_Table *env) {
   }
 
   Parse_Node *condition = eval_parse_node(args->first, env);
+  if (is_return(condition)) {
+    return condition;
+  }
   Parse_Node *ret;
   if (bool_value(condition)) {
     ret = eval_parse_node(args->next->first, env);
@@ -812,7 +1344,7 @@ Parse_Node *builtin_print(Parse_Node *args, Symbol_Table *env) {
   Parse_Node *ret = nullptr;
   while (args->first != nullptr) {
     Parse_Node *earg = eval_parse_node(args->first, env);
-    std::cout << earg->print() << std::endl;
+    std::cout << print_node(earg) << std::endl;
     ret = earg;
     args = args->next;
   }
@@ -823,10 +1355,10 @@ Parse_Node *builtin_print(Parse_Node *args, Symbol_Table *env) {
 }
 
 Parse_Node *builtin_for_each(Parse_Node *args, Symbol_Table *env) {
-  ARG_COUNT_EXACT("for-each", 1);
+  ARG_COUNT_MIN("for-each", 1);
 
   Parse_Node *binding = args->first;
-  if (binding->type != PARSE_NODE_LIST) {
+  if (!is_list(binding)) {
     fprintf(stderr, "Error: for-each binding must be a list\n");
     return nullptr;
   }
@@ -837,25 +1369,44 @@ Parse_Node *builtin_for_each(Parse_Node *args, Symbol_Table *env) {
   }
 
   Parse_Node *sym = binding->first;
-  if (sym->type != PARSE_NODE_SYMBOL) {
+  if (!is_sym(sym)) {
     fprintf(stderr, "Error: for-each binding first argument is not a symbol\n");
     return nullptr;    
   }
 
   Parse_Node *list = eval_parse_node(binding->next->first, env);
-  if (list->type != PARSE_NODE_LIST) {
-    fprintf(stderr, "Error: for-each binding second argument is not a list\n");
+  if (is_return(list)) {
+    return list;
+  }
+  if (!is_list(list) && !is_indexed(list)) {
+    fprintf(stderr, "Error: for-each binding second argument is not a list, vector or array\n");
     return nullptr;    
   }
   
   Symbol_Table *for_each_env = new Symbol_Table(env);
-  Parse_Node *cur = list;
   Parse_Node *ret = args->first; // this way if there is no body the empty list is returned
+  if (is_indexed(list)) {
+    // by index, the body may append to a vector
+    for (size_t i = 0; i < indexed_length(list); i++) {
+      for_each_env->define(sym->aux, indexed_element(list, i));
+      for (Parse_Node *body = args->next; body->first != nullptr; body = body->next) {
+	ret = eval_parse_node(body->first, for_each_env);
+	if (is_return(ret)) {
+	  return ret;
+	}
+      }
+    }
+    return ret;
+  }
+  Parse_Node *cur = list;
   while (cur->first != nullptr) {
-    for_each_env->table[sym->token.name] = cur->first;
+    for_each_env->define(sym->aux, cur->first);
     Parse_Node *body = args->next;
     while (body->first != nullptr) {
       ret = eval_parse_node(body->first, for_each_env);
+      if (is_return(ret)) {
+	return ret;
+      }
       body = body->next;
     }
     cur = cur->next;
@@ -863,15 +1414,6 @@ Parse_Node *builtin_for_each(Parse_Node *args, Symbol_Table *env) {
   return ret;
 }
 
-bool evals_to_true(Parse_Node *node, Symbol_Table *env) {
-  Parse_Node *val = eval_parse_node(node, env);
-  if (!is_bool(val)) {
-    fprintf(stderr, "Error: while condition didn't evaluate to a boolean\n");
-    return false;
-  }
-  return val->val.b;
-}
-
 Parse_Node *builtin_while(Parse_Node *args, Symbol_Table *env) {
   ARG_COUNT_MIN("while", 2);
 
@@ -879,10 +1421,24 @@ Parse_Node *builtin_while(Parse_Node *args, Symbol_Table *env) {
   Parse_Node *body = args->next;
   Parse_Node *ret = nullptr;
 
-  while(evals_to_true(condition, env)) {
+  while (true) {
+    Parse_Node *val = eval_parse_node(condition, env);
+    if (is_return(val)) {
+      return val;
+    }
+    if (!is_bool(val)) {
+      fprintf(stderr, "Error: while condition didn't evaluate to a boolean\n");
+      break;
+    }
+    if (!val->val.b) {
+      break;
+    }
     Parse_Node *cur = body;
     while (!is_empty_list(cur)) {
       ret = eval_parse_node(cur->first, env);
+      if (is_return(ret)) {
+	return ret;
+      }
       cur = cur->next;
     }
   }
@@ -893,7 +1449,7 @@ Parse_Node *builtin_while(Parse_Node *args, Symbol_Table *env) {
 
   // printf("leaving while\n");
   // printf("        ret is null: %s\n", ret == nullptr ? "true" : "false");
-  // printf("        while ret: %s\n", ret->print().c_str());
+  // printf("        while ret: %s\n", print_node(ret).c_str());
   
   return ret;
 }
@@ -908,19 +1464,22 @@ Parse_Node *builtin_set(Parse_Node *args, Symbol_Table *env) {
   }
   
   Parse_Node *val = eval_parse_node(args->next->first, env);
+  if (is_return(val)) {
+    return val;
+  }
   
   if (is_sym(sym)) {    
-    env->set(sym->token.name, val);  
+    env->set(sym->aux, val);  
     return sym;
   }
 
   Parse_Node *acc_form = sym;
   sym = sym->first;
   if (!is_sym(sym)) {
-    throw runtimeError("Error: set given invalid accessor, " + sym->print() + " is not a symbol\n");
+    throw runtimeError("Error: set given invalid accessor, " + print_node(sym) + " is not a symbol\n");
   }
   
-  std::string sy = sym->token.name;
+  std::string sy = symbol_name(sym);
   
   Parse_Node *place;
   if (sy == "first") {
@@ -941,22 +1500,32 @@ Parse_Node *builtin_set(Parse_Node *args, Symbol_Table *env) {
     throw runtimeError("Error: keyword symbols cannot be reassigned\n");
   }
 
-  if (is_list(place)) {
+  if (is_indexed(place)) {
+    if (indexed_length(place) == 0) {
+      throw runtimeError("Error: can't set an element of an empty " +
+			 std::string(is_vector(place) ? "vector" : "array") + "\n");
+    }
+    if (is_vector(place)) {
+      vector_value(place)[place->aux] = val;
+    } else {
+      set_array_element(place, place->aux, val);
+    }
+  } else if (is_list(place)) {
     place->first = val;
   } else if (is_string(place)) {
     if (!is_string(val)) {
       throw runtimeError("Error: can only set a character to be a character\n");
     }
-    char newc = val->token.name[0];
+    char newc = string_value(val)[0];
     if (sy == "first") {
-      place->token.name[0] = newc;
+      string_value(place)[0] = newc;
 
     } else if (sy == "last") {
-      int l = place->token.name.length() - 1;
-      place->token.name[l] = newc;
+      int l = string_value(place).length() - 1;
+      string_value(place)[l] = newc;
     
     } else if (sy == "nth") {
-      place->token.name[place->val.u64] = newc;
+      string_value(place)[place->aux] = newc;
     
     } else {
       throw runtimeError("Error: no set accessor named " +  sy + " found\n");
@@ -968,12 +1537,12 @@ Parse_Node *builtin_set(Parse_Node *args, Symbol_Table *env) {
 
 Parse_Node *single_type_of(Parse_Node *arg, Symbol_Table *env) {
   Parse_Node *node = eval_parse_node(arg, env);
-  Parse_Node *ret = new Parse_Node{PARSE_NODE_SYMBOL};
   std::string name;
-  switch (node->type) {
+  switch (node_type(node)) {
   case PARSE_NODE_LITERAL: {
-    switch (node->subtype) {
-    case LITERAL_INTEGER: {
+    switch (node_subtype(node)) {
+    case LITERAL_INTEGER:
+    case LITERAL_BIGNUM: {
       name = "integer";  
       break;
     }
@@ -1000,6 +1569,21 @@ Parse_Node *single_type_of(Parse_Node *arg, Symbol_Table *env) {
     name = "list";
     break;
   }
+
+  case PARSE_NODE_VECTOR: {
+    name = "vector";
+    break;
+  }
+
+  case PARSE_NODE_HASH: {
+    name = "hash";
+    break;
+  }
+
+  case PARSE_NODE_ARRAY: {
+    name = (node->subtype == ARRAY_INT64) ? "int-array" : "float-array";
+    break;
+  }
     
   case PARSE_NODE_SYMBOL: {
     name = "symbol";
@@ -1015,8 +1599,7 @@ Parse_Node *single_type_of(Parse_Node *arg, Symbol_Table *env) {
     fprintf(stderr, "Error: unknown type\n");
     return nullptr;
   }
-  ret->token.name = name;
-  return ret;
+  return make_symbol(name);
 }
 
 Parse_Node *builtin_type_of(Parse_Node *args, Symbol_Table *env) {
@@ -1042,7 +1625,10 @@ Parse_Node *builtin_type_equal(Parse_Node *args, Symbol_Table *env) {
   args = args->next;
   while (!is_empty_list(args)) {
     Parse_Node *cur = eval_parse_node(args->first, env);
-    if (cur->type != prev->type || cur->subtype != prev->subtype) {
+    // bignums are integers too
+    bool both_integers = (is_integer(cur) || is_bignum(cur)) && (is_integer(prev) || is_bignum(prev));
+    if (!both_integers &&
+	(node_type(cur) != node_type(prev) || node_subtype(cur) != node_subtype(prev))) {
       return fal;
     }
     prev = cur;
@@ -1056,7 +1642,7 @@ Parse_Node *builtin_symbol_equal(Parse_Node *args, Symbol_Table *env) {
   
   Parse_Node *first = eval_parse_node(args->first, env);
   if(!is_sym(first)) {
-    fprintf(stderr, "Error: %s does not evaluate to a symbol\n", args->first->print().c_str());
+    fprintf(stderr, "Error: %s does not evaluate to a symbol\n", print_node(args->first).c_str());
     return nullptr;
   }
   
@@ -1064,11 +1650,11 @@ Parse_Node *builtin_symbol_equal(Parse_Node *args, Symbol_Table *env) {
   while (!is_empty_list(args)) {
     Parse_Node *cur = eval_parse_node(args->first, env);
     if(!is_sym(cur)) {
-      fprintf(stderr, "Error: %s does not evaluate to a symbol\n", args->first->print().c_str());
+      fprintf(stderr, "Error: %s does not evaluate to a symbol\n", print_node(args->first).c_str());
       return nullptr;
     }
     
-    if (cur->token.name != first->token.name) {
+    if (cur->aux != first->aux) {
       return fal;
     }
     args = args->next;
@@ -1081,7 +1667,7 @@ Parse_Node *builtin_string_equal(Parse_Node *args, Symbol_Table *env) {
 
   Parse_Node *first = eval_parse_node(args->first, env);
   if(!is_string(first)) {
-    fprintf(stderr, "Error: %s does not evaluate to a string\n", args->first->print().c_str());
+    fprintf(stderr, "Error: %s does not evaluate to a string\n", print_node(args->first).c_str());
     return nullptr;
   }
   
@@ -1089,11 +1675,11 @@ Parse_Node *builtin_string_equal(Parse_Node *args, Symbol_Table *env) {
   while (!is_empty_list(args)) {
     Parse_Node *cur = eval_parse_node(args->first, env);
     if(!is_string(cur)) {
-      fprintf(stderr, "Error: %s does not evaluate to a string\n", args->first->print().c_str());
+      fprintf(stderr, "Error: %s does not evaluate to a string\n", print_node(args->first).c_str());
       return nullptr;
     }
     
-    if (cur->token.name != first->token.name) {
+    if (string_value(cur) != string_value(first)) {
       return fal;
     }
     args = args->next;
@@ -1107,18 +1693,22 @@ void load_file(std::string file_name, Symbol_Table *env) {
   parse.parse_top_level_expressions();
 
   for (int i = 0; i < parse.top_level_expressions.size(); i++) {
-    Parse_Node *evaled = eval_parse_node(parse.top_level_expressions[i], env);
+    Parse_Node *form = fold_constants(parse.top_level_expressions[i], env);
+    Parse_Node *evaled = eval_parse_node(form, env);
+    if (is_return(evaled)) {
+      take_return();
+    }
   }
 }
 
 Parse_Node *builtin_load(Parse_Node *args, Symbol_Table *env) {
   while (args->first != nullptr) {
     Parse_Node *earg = eval_parse_node(args->first, env);
-    if (args->first->subtype != LITERAL_STRING) {
-      fprintf(stderr, "Error: %s is not a string\n", earg->print().c_str());
+    if (node_subtype(args->first) != LITERAL_STRING) {
+      fprintf(stderr, "Error: %s is not a string\n", print_node(earg).c_str());
       return nullptr;
     }
-    load_file(earg->token.name, env);
+    load_file(string_value(earg), env);
     args = args->next;
   }
   return tru;
@@ -1127,87 +1717,211 @@ Parse_Node *builtin_load(Parse_Node *args, Symbol_Table *env) {
 Parse_Node *builtin_get_int(Parse_Node *args, Symbol_Table *env) {
   ARG_COUNT_ZERO("get-int");
 
-  Parse_Node *ret = new Parse_Node{PARSE_NODE_LITERAL, LITERAL_INTEGER};
-  std::cin >> ret->val.u64;
+  int64_t value = 0;
+  std::cin >> value;
   std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-  return ret;
+  return make_integer(value);
+}
+
+Parse_Node *builtin_gc(Parse_Node *args, Symbol_Table *env) {
+  ARG_COUNT_ZERO("gc");
+
+  return make_integer(gc_collect());
+}
+
+// returns a property list, (:collections n :live-objects n ...)
+Parse_Node *builtin_gc_stats(Parse_Node *args, Symbol_Table *env) {
+  ARG_COUNT_ZERO("gc-stats");
+
+  std::pair<const char *, uint64_t> stats[] = {
+    {":collections", gc_stats.collections},
+    {":objects-allocated", gc_stats.objects_allocated},
+    {":objects-freed", gc_stats.objects_freed},
+    {":live-objects", gc_stats.live_objects},
+    {":live-bytes", gc_stats.live_bytes},
+    {":total-pause-us", (uint64_t)(gc_stats.total_pause_ms * 1000)},
+    {":slabs", slab_stats.slabs},
+  };
+
+  Parse_Node *list = new Parse_Node{PARSE_NODE_LIST};
+  Parse_Node *cur = list;
+  for (auto &stat : stats) {
+    cur->first = make_symbol(stat.first);
+    cur->next = new Parse_Node{PARSE_NODE_LIST};
+    cur = cur->next;
+
+    cur->first = make_integer(stat.second);
+    cur->next = new Parse_Node{PARSE_NODE_LIST};
+    cur = cur->next;
+  }
+  return list;
 }
 
-void create_builtin(std::string symbol, Parse_Node *(*func)(Parse_Node *, Symbol_Table *), Symbol_Table *env) {
-  Parse_Node *f = new Parse_Node{PARSE_NODE_FUNCTION, FUNCTION_BUILTIN};
+// microseconds on a monotonic clock, for timing parts of a program
+Parse_Node *builtin_clock_us(Parse_Node *args, Symbol_Table *env) {
+  ARG_COUNT_ZERO("clock-us");
+
+  auto now = std::chrono::steady_clock::now().time_since_epoch();
+  return make_integer(std::chrono::duration_cast<std::chrono::microseconds>(now).count());
+}
+
+Parse_Node *builtin_call_cache_stats(Parse_Node *args, Symbol_Table *env) {
+  ARG_COUNT_ZERO("call-cache-stats");
+
+  Parse_Node *list = new Parse_Node{PARSE_NODE_LIST};
+  Parse_Node *cur = list;
+  std::pair<const char *, uint64_t> stats[] = {
+    {":hits", call_cache_hits},
+    {":misses", call_cache_misses},
+    {":epoch", definition_epoch},
+  };
+  for (auto &stat : stats) {
+    cur->first = make_symbol(stat.first);
+    cur->next = new Parse_Node{PARSE_NODE_LIST};
+    cur = cur->next;
+
+    cur->first = make_integer(stat.second);
+    cur->next = new Parse_Node{PARSE_NODE_LIST};
+    cur = cur->next;
+  }
+  return list;
+}
+
+void create_builtin(std::string symbol, Parse_Node *(*func)(Parse_Node *, Symbol_Table *), Symbol_Table *env, uint16_t flags = 0) {
+  Parse_Node *f = new Parse_Node{PARSE_NODE_FUNCTION, FUNCTION_BUILTIN, flags};
   f->val.func = func;
-  f->token.name = symbol;
-  env->insert(symbol, f);
+  f->aux = intern_symbol(symbol);
+  env->insert(f->aux, f);
+}
+
+// the Value_Builtin lives as long as the program, like the builtin itself
+void create_builtin(std::string symbol, Values_Func func, uint32_t min_args, uint32_t max_args, Symbol_Table *env) {
+  Parse_Node *f = new Parse_Node{PARSE_NODE_FUNCTION, FUNCTION_BUILTIN,
+				 NODE_STRICT_BUILTIN | NODE_VALUE_BUILTIN};
+  f->val.builtin = new Value_Builtin{func, min_args, max_args};
+  f->aux = intern_symbol(symbol);
+  env->insert(f->aux, f);
 }
 
-Symbol_Table create_base_environment() {
-  Symbol_Table env = Symbol_Table();
+Symbol_Table *create_base_environment() {
+  Symbol_Table *env = new Symbol_Table();
+  gc_add_root(env);
+  global_env = env;
+  init_native_stack_limit((char *)__builtin_frame_address(0));
 
   tru = new Parse_Node{PARSE_NODE_LITERAL, LITERAL_BOOLEAN};
   tru->val.b = true;
+  gc_add_root(&tru);
   fal = new Parse_Node{PARSE_NODE_LITERAL, LITERAL_BOOLEAN};
   fal->val.b = false;
+  gc_add_root(&fal);
+  return_signal = new Parse_Node{PARSE_NODE_ERROR};
+  gc_add_root(&return_signal);
+  gc_add_root(&pending_return);
+  tail_call_signal = new Parse_Node{PARSE_NODE_ERROR};
+  gc_add_root(&tail_call_signal);
+  gc_add_root(&tail_fun);
+  gc_add_root(&tail_env);
+
+  gc_add_root(&expansion_roots);
+  gc_add_root(&value_args);
   
-  env.insert("true", tru);
-  env.insert("false", fal);
-
-  create_builtin("defun", builtin_defun, &env);  
-  create_builtin("defmacro", builtin_defmacro, &env);
-  create_builtin("return", builtin_return, &env);
-  create_builtin("expand", builtin_expand, &env);
-  create_builtin("defsym", builtin_defsym, &env);
-  create_builtin("set", builtin_set, &env);
-  create_builtin("let", builtin_let, &env);
-  create_builtin("progn", builtin_progn, &env);
-  create_builtin("if", builtin_if, &env);
-  create_builtin("eval", builtin_eval, &env);
-  create_builtin("print", builtin_print, &env);
-  create_builtin("for-each", builtin_for_each, &env);
-  create_builtin("load", builtin_load, &env);
-  create_builtin("while", builtin_while, &env);
-  create_builtin("type-of", builtin_type_of, &env);
-  create_builtin("type=", builtin_type_equal, &env);
-  create_builtin("symbol=", builtin_symbol_equal, &env);
-  create_builtin("string=", builtin_symbol_equal, &env);
-  create_builtin("get-int", builtin_get_int, &env);
-
-  create_builtin("inspect-macro", builtin_inspect_macro, &env);
-
-  create_builtin("list", builtin_list, &env);
-  create_builtin("first", builtin_first, &env);
-  create_builtin("last", builtin_last, &env);
-  create_builtin("nth", builtin_nth, &env);
-  create_builtin("pop", builtin_pop, &env);
-  create_builtin("push", builtin_push, &env);
-  create_builtin("append", builtin_append, &env);
-  create_builtin("length", builtin_length, &env);
-  create_builtin("quote", builtin_quote, &env);
-  create_builtin("empty?", builtin_empty_q, &env);
-  create_builtin("~", builtin_string_concatenate, &env);
-  create_builtin("copy", builtin_copy, &env);
-
-  create_builtin("+", builtin_add, &env);
-  create_builtin("-", builtin_subtract, &env);
-  create_builtin("*", builtin_multiply, &env);
+  sym_rest = intern_symbol("&rest");
+  sym_opt = intern_symbol("&opt");
+  sym_optional = intern_symbol("&optional");
+
+  env->insert(intern_symbol("true"), tru);
+  env->insert(intern_symbol("false"), fal);
+
+  create_builtin("defun", builtin_defun, env);  
+  create_builtin("defmacro", builtin_defmacro, env);
+  create_builtin("return", builtin_return, env);
+  create_builtin("expand", builtin_expand, env);
+  create_builtin("defsym", builtin_defsym, env);
+  create_builtin("set", builtin_set, env);
+  create_builtin("let", builtin_let, env);
+  create_builtin("progn", builtin_progn, env);
+  create_builtin("if", builtin_if, env);
+  create_builtin("eval", builtin_eval, env, NODE_STRICT_BUILTIN);
+  create_builtin("print", builtin_print, env);
+  create_builtin("for-each", builtin_for_each, env);
+  create_builtin("load", builtin_load, env);
+  create_builtin("while", builtin_while, env);
+  create_builtin("type-of", builtin_type_of, env, NODE_STRICT_BUILTIN);
+  create_builtin("type=", builtin_type_equal, env, NODE_STRICT_BUILTIN);
+  create_builtin("symbol=", builtin_symbol_equal, env, NODE_STRICT_BUILTIN);
+  create_builtin("string=", builtin_symbol_equal, env, NODE_STRICT_BUILTIN);
+  create_builtin("get-int", builtin_get_int, env);
+
+  create_builtin("inspect-macro", builtin_inspect_macro, env);
+
+  create_builtin("list", builtin_list, 0, UINT32_MAX, env);
+  create_builtin("vector", builtin_vector, 0, UINT32_MAX, env);
+  create_builtin("make-vector", builtin_make_vector, 1, 2, env);
+  create_builtin("first", builtin_first, env, NODE_STRICT_BUILTIN);
+  create_builtin("last", builtin_last, env, NODE_STRICT_BUILTIN);
+  create_builtin("nth", builtin_nth, env, NODE_STRICT_BUILTIN);
+  create_builtin("pop", builtin_pop, env, NODE_STRICT_BUILTIN);
+  create_builtin("push", builtin_push, 2, 2, env);
+  create_builtin("append", builtin_append, env);
+  create_builtin("length", builtin_length, 1, 1, env);
+  create_builtin("quote", builtin_quote, env);
+
+  create_builtin("empty?", builtin_empty_q, env, NODE_STRICT_BUILTIN);
+  create_builtin("~", builtin_string_concatenate, env, NODE_STRICT_BUILTIN);
+  create_builtin("copy", builtin_copy, env, NODE_STRICT_BUILTIN);
+
+  create_builtin("make-hash", builtin_make_hash, 0, 0, env);
+  create_builtin("hash-get", builtin_hash_get, 2, 3, env);
+  create_builtin("hash-set", builtin_hash_set, 3, 3, env);
+  create_builtin("hash-remove", builtin_hash_remove, 2, 2, env);
+  create_builtin("hash-count", builtin_hash_count, 1, 1, env);
+  create_builtin("hash-for-each", builtin_hash_for_each, env);
+
+  create_builtin("int-array", builtin_int_array, 0, UINT32_MAX, env);
+  create_builtin("float-array", builtin_float_array, 0, UINT32_MAX, env);
+  create_builtin("make-int-array", builtin_make_int_array, 1, 2, env);
+  create_builtin("make-float-array", builtin_make_float_array, 1, 2, env);
+  create_builtin("array-sum", builtin_array_sum, 1, 1, env);
+  create_builtin("array-min", builtin_array_min, 1, 1, env);
+  create_builtin("array-max", builtin_array_max, 1, 1, env);
+  create_builtin("array-dot", builtin_array_dot, 2, 2, env);
+  create_builtin("array-scale", builtin_array_scale, 2, 2, env);
+  create_builtin("array-add", builtin_array_add, 2, 2, env);
+  create_builtin("array-mul", builtin_array_mul, 2, 2, env);
+  create_builtin("array-and", builtin_array_and, 2, 2, env);
+  create_builtin("array-or", builtin_array_or, 2, 2, env);
+  create_builtin("array-xor", builtin_array_xor, 2, 2, env);
+  create_builtin("array-shl", builtin_array_shift_left, 1, 2, env);
+  create_builtin("array-shr", builtin_array_shift_right, 1, 2, env);
+
+  create_builtin("+", builtin_add, 0, UINT32_MAX, env);
+  create_builtin("-", builtin_subtract, 1, UINT32_MAX, env);
+  create_builtin("*", builtin_multiply, 0, UINT32_MAX, env);
   
-  create_builtin("=", builtin_equal, &env);
-  create_builtin("<", builtin_less_than, &env);
-  create_builtin("<=", builtin_less_than_equal, &env);
-  create_builtin(">", builtin_greater_than, &env);
-  create_builtin(">=", builtin_greater_than_equal, &env);
-
-  create_builtin("and", builtin_and, &env);
-  create_builtin("or", builtin_or, &env);
-  create_builtin("not", builtin_not, &env);
+  create_builtin("=", builtin_equal, 1, UINT32_MAX, env);
+  create_builtin("<", builtin_less_than, 1, UINT32_MAX, env);
+  create_builtin("<=", builtin_less_than_equal, 1, UINT32_MAX, env);
+  create_builtin(">", builtin_greater_than, 1, UINT32_MAX, env);
+  create_builtin(">=", builtin_greater_than_equal, 1, UINT32_MAX, env);
+
+  create_builtin("and", builtin_and, env);
+  create_builtin("or", builtin_or, env);
+  create_builtin("not", builtin_not, 1, 1, env);
   
-  create_builtin("&", builtin_bitand, &env);
-  create_builtin("|", builtin_bitor, &env);
-  create_builtin("^", builtin_bitxor, &env);
-  create_builtin("~", builtin_bitnot, &env);
-  create_builtin("<<", builtin_bitshift_left, &env);
-  create_builtin(">>", builtin_bitshift_right, &env);
-
-  load_file("native.lisp", &env);
+  create_builtin("&", builtin_bitand, 2, 2, env);
+  create_builtin("|", builtin_bitor, 2, 2, env);
+  create_builtin("^", builtin_bitxor, 2, 2, env);
+  create_builtin("~", builtin_bitnot, 1, 1, env);
+  create_builtin("<<", builtin_bitshift_left, 1, 2, env);
+  create_builtin(">>", builtin_bitshift_right, 1, 2, env);
+
+  create_builtin("gc", builtin_gc, env);
+  create_builtin("gc-stats", builtin_gc_stats, env);
+  create_builtin("clock-us", builtin_clock_us, env);
+  create_builtin("call-cache-stats", builtin_call_cache_stats, env);
+
+  load_file("native.lisp", env);
 
   return env;
 }
@@ -3,7 +3,163 @@
 
 bool is_error(Parse_Node *node);
 
+// how native function bodies are run, see closure.h and vm.h
+enum Engine {
+  ENGINE_TREE,
+  ENGINE_CLOSURE,
+  ENGINE_VM,
+};
+
+extern Engine engine;
+
+// `return` doesn't unwind the C++ stack. builtin_return stores its value and
+// evaluates to return_signal, which every form that sequences evaluation
+// (bodies, if, while, let, for-each, and, or, set and function arguments)
+// hands up unchanged until the call it belongs to takes the value with
+// take_return.
+extern Parse_Node *return_signal;
+
+inline bool is_return(Parse_Node *node) {
+  return node == return_signal;
+}
+
+Parse_Node *take_return();
+// stores value for take_return and returns return_signal
+Parse_Node *signal_return(Parse_Node *value);
+
+// A call in tail position doesn't run the callee, it binds the callee's
+// frame and evaluates to tail_call_signal. Only run_body, which loops on
+// the pending call, ever sees the signal.
+extern Parse_Node *tail_call_signal;
+
+inline bool is_tail_call(Parse_Node *node) {
+  return node == tail_call_signal;
+}
+
+Parse_Node *signal_tail_call(Parse_Node *fun, Symbol_Table *fun_env);
+
+// Nested function calls are limited to max_call_depth (--max-depth), and
+// the engines that recurse on the C++ stack also stop well before it runs
+// out. Going past either throws stackExhausted, which abandons the whole
+// top level form. Walks over nested forms that recurse without calling
+// anything check it as well.
+extern uint32_t max_call_depth;
+extern uint32_t call_depth;
+
+// whether check_call_depth would throw
+bool stack_exhausted();
+void check_call_depth();
+
+// counts one nested call for as long as it's in scope
+struct Call_Depth {
+  Call_Depth() {
+    check_call_depth();
+    call_depth++;
+  }
+  ~Call_Depth() { call_depth--; }
+};
+
+// Runtime errors are error nodes, which builtins pass on as values. Errors
+// on paths that run in ordinary programs, unbound symbols and unknown
+// operators, are made with error_value where they happen. Builtins and
+// their helpers still throw runtimeError for bad arguments, which
+// eval_parse_node and the closure and vm call paths catch by reference and
+// turn into an error node. A try block costs nothing until something is
+// thrown, so only failing calls pay for the unwinding.
+
+// prints message and returns a new error node
+Parse_Node *error_value(const std::string &message);
+
+// The parameter list of a native function or macro, parsed once by defun or
+// defmacro and kept on the list node. A frame binds the required
+// parameters, then the optional ones, then rest, in that order.
+struct Lambda_List {
+  std::vector<uint32_t> required;
+  std::vector<uint32_t> optional;
+  // default form of each optional parameter, nullptr binds false
+  std::vector<Parse_Node *> defaults;
+  uint32_t rest = Symbol_Table::EMPTY;
+
+  bool is_fixed() const { return optional.empty() && rest == Symbol_Table::EMPTY; }
+};
+
+inline const Lambda_List *lambda_list(const Parse_Node *fun) {
+  return fun->first->val.lambda_list;
+}
+
+typedef Parse_Node *(*Builtin_Func)(Parse_Node *args, Symbol_Table *env);
+typedef Parse_Node *(*Values_Func)(Parse_Node **args, uint32_t argc);
+
+// Builtins come in two kinds. Special forms, and anything else that decides
+// how its arguments are evaluated, get the argument forms and the
+// environment in val.func. A builtin that only needs the values has
+// NODE_VALUE_BUILTIN set and gets them evaluated, in order, as an array. Its
+// arity is declared here and checked by the caller, so the function can
+// index args directly.
+struct Value_Builtin {
+  Values_Func func;
+  uint32_t min_args;
+  uint32_t max_args;  // UINT32_MAX for no limit
+};
+
+// val.func of a builtin, nullptr for value builtins
+inline Builtin_Func forms_func(const Parse_Node *builtin) {
+  return (builtin->flags & NODE_VALUE_BUILTIN) ? nullptr : builtin->val.func;
+}
+
+// the function of a value builtin, nullptr for other builtins
+inline Values_Func values_func(const Parse_Node *builtin) {
+  return (builtin->flags & NODE_VALUE_BUILTIN) ? builtin->val.builtin->func : nullptr;
+}
+
+// calls the builtin with the argument forms args, either kind
+Parse_Node *apply_builtin(Parse_Node *builtin, Parse_Node *args, Symbol_Table *env);
+[[noreturn]] void throw_arity_error(Parse_Node *builtin, uint32_t argc);
+
+// calls a value builtin, throws if argc is outside its arity
+inline Parse_Node *call_values(Parse_Node *builtin, Parse_Node **args, uint32_t argc) {
+  const Value_Builtin *b = builtin->val.builtin;
+  if (argc < b->min_args || argc > b->max_args) {
+    throw_arity_error(builtin, argc);
+  }
+  return b->func(args, argc);
+}
+
 Parse_Node *eval_parse_node(Parse_Node *node, Symbol_Table *env);
 Parse_Node *apply_function(Parse_Node *node, Symbol_Table *env);
   
-Symbol_Table create_base_environment();
+Symbol_Table *create_base_environment();
+
+Parse_Node *apply_fun(Parse_Node *fun, Parse_Node *node, Symbol_Table *env);
+Symbol_Table *bind_arguments(Parse_Node *fun, Parse_Node *node, Symbol_Table *env);
+Parse_Node *run_body(Parse_Node *fun, Symbol_Table *fun_env);
+Parse_Node *eval_body(Parse_Node *forms, Symbol_Table *env);
+Parse_Node *eval_tail(Parse_Node *node, Symbol_Table *env);
+Parse_Node *copy_node(Parse_Node *node);
+
+// expansion of the macro call node, computed once per call site and kept
+// until the macro is redefined
+Parse_Node *expand_macro(Parse_Node *macro, Parse_Node *node, Symbol_Table *env);
+// moves on with every defmacro, code built from an expansion checks it
+uint32_t current_macro_epoch();
+// called by the collector when a node with NODE_HAS_EXPANSION is freed
+void macro_forget(Parse_Node *node);
+
+// whether evaluating list splices, parsed lists answer from NODE_HAS_SPLICE
+// and lists built at run time are scanned
+bool has_splice(Parse_Node *list);
+
+Parse_Node *builtin_if(Parse_Node *args, Symbol_Table *env);
+Parse_Node *builtin_while(Parse_Node *args, Symbol_Table *env);
+Parse_Node *builtin_set(Parse_Node *args, Symbol_Table *env);
+Parse_Node *builtin_progn(Parse_Node *args, Symbol_Table *env);
+Parse_Node *builtin_eval(Parse_Node *args, Symbol_Table *env);
+Parse_Node *builtin_return(Parse_Node *args, Symbol_Table *env);
+Parse_Node *builtin_quote(Parse_Node *args, Symbol_Table *env);
+Parse_Node *builtin_let(Parse_Node *args, Symbol_Table *env);
+Parse_Node *builtin_for_each(Parse_Node *args, Symbol_Table *env);
+Parse_Node *builtin_defun(Parse_Node *args, Symbol_Table *env);
+Parse_Node *builtin_defmacro(Parse_Node *args, Symbol_Table *env);
+Parse_Node *builtin_defsym(Parse_Node *args, Symbol_Table *env);
+Parse_Node *builtin_expand(Parse_Node *args, Symbol_Table *env);
+Parse_Node *builtin_inspect_macro(Parse_Node *args, Symbol_Table *env);
@@ -1,11 +1,13 @@
 #pragma once
-struct returnException: public std::exception {
-  Parse_Node *ret;
+// not a runtimeError, nothing catches it before the top level form is
+// abandoned
+struct stackExhausted: public std::exception {
+  std::string err;
   const char * what () const throw () {
-    return "";
+    return err.c_str();
   }
-  returnException(Parse_Node *r) {
-    ret = r;
+  stackExhausted(std::string e) {
+    err = e;
   }
 };
 
@@ -60,6 +60,16 @@ Token Lexer::next_token() {
     character++;
     t = Token{TOKEN_R_PAREN, line, character-1, line, character-1};
 
+  } else if (c == '[') {
+    pos++;
+    character++;
+    t = Token{TOKEN_L_BRACKET, line, character-1, line, character-1};
+
+  } else if (c == ']') {
+    pos++;
+    character++;
+    t = Token{TOKEN_R_BRACKET, line, character-1, line, character-1};
+
   } else if (c == '\'') {    
     pos++;
     character++;
@@ -133,7 +143,8 @@ Token Lexer::read_identifier() {
   int source_size = source.size();
   char c = source[pos];
   int count = 0;
-  while (c != ' ' && c != '\n' && c != '\t' && c != '(' && c != ')') {
+  while (c != ' ' && c != '\n' && c != '\t' && c != '(' && c != ')' &&
+	 c != '[' && c != ']') {
     t.name.push_back(c);
     ++count;
     pos++;
@@ -222,6 +233,12 @@ void print_token_type(Token_Type t) {
   case TOKEN_R_PAREN:
     printf("TOKEN_R_PAREN");
     break;
+  case TOKEN_L_BRACKET:
+    printf("TOKEN_L_BRACKET");
+    break;
+  case TOKEN_R_BRACKET:
+    printf("TOKEN_R_BRACKET");
+    break;
   case TOKEN_IDENTIFIER:
     printf("TOKEN_IDENTIFIER");
     break;
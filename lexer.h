@@ -8,6 +8,8 @@ std::string get_whole_file(const char* filename);
 enum Token_Type {
   TOKEN_L_PAREN,
   TOKEN_R_PAREN,
+  TOKEN_L_BRACKET,
+  TOKEN_R_BRACKET,
   TOKEN_IDENTIFIER,
   TOKEN_INTEGER,
   TOKEN_FLOAT,
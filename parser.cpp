@@ -1,6 +1,11 @@
 #include <iostream>
 #include <string>
+#include <deque>
+#include <set>
+#include <unordered_map>
 #include "parser.h"
+#include "hash_table.h"
+#include "bignum.h"
 
 const char *parse_node_types[] = {
   "PARSE_NODE_LIST",
@@ -8,7 +13,10 @@ const char *parse_node_types[] = {
   "PARSE_NODE_LITERAL",
   "PARES_NODE_FUNCTION",
   "PARES_NODE_SYNTAX",
-  "PARES_NODE_ERROR"
+  "PARES_NODE_ERROR",
+  "PARSE_NODE_VECTOR",
+  "PARSE_NODE_HASH",
+  "PARSE_NODE_ARRAY"
 };
 
 const char *parse_node_subtypes[] = {
@@ -21,6 +29,7 @@ const char *parse_node_subtypes[] = {
   "LITERAL_FLOAT",
   "LITERAL_STRING",
   "LITERAL_BOOLEAN",
+  "LITERAL_BIGNUM",
   "FUNCTION_MACRO",
   "FUNCTION_BUILTIN",
   "FUNCTION_NATIVE",
@@ -28,6 +37,8 @@ const char *parse_node_subtypes[] = {
   "SYNTAX_BACKTICK",
   "SYNTAX_COMMA",
   "SYNTAX_COMMA_AT",
+  "ARRAY_INT64",
+  "ARRAY_FLOAT64",
 };
 
 Parse_Node *Parser::parse_text(std::string input) {
@@ -61,40 +72,44 @@ Parse_Node *Parser::parse_next_token() {
     exit(1);
     break;
 
+  case TOKEN_L_BRACKET: {
+    return parse_vector(t);
+  }
+
+  case TOKEN_R_BRACKET:
+    std::cerr << "Unexpected ']' at " << lex.filename << ":";
+    t.print_position();
+    std::cerr << "\n";
+    exit(1);
+    break;
+
   case TOKEN_IDENTIFIER: {
-    Parse_Node *sym = new Parse_Node{PARSE_NODE_SYMBOL};
-    if (t.name[0] == ':') {
-      sym->subtype = SYMBOL_KEYWORD;
-    }
-    sym->token = t;
-    sym->nesting_depth = current_depth;
+    Parse_Node *sym = make_symbol(t.name);
+    set_source_location(sym, file_name, t);
     return sym;
     break;
   }
     
   case TOKEN_STRING: {
-    Parse_Node *str = new Parse_Node{PARSE_NODE_LITERAL, LITERAL_STRING};
-    str->token = t;
-    str->nesting_depth = current_depth;
+    Parse_Node *str = make_string(t.name);
+    set_source_location(str, file_name, t);
     return str;
     break;
   }
 
   case TOKEN_INTEGER: {
-    uint64_t value = std::stoi(t.name);
-    Parse_Node *integer = new Parse_Node{PARSE_NODE_LITERAL, LITERAL_INTEGER, t};
-    integer->val.u64=value;
-    integer->nesting_depth = current_depth;
-    return integer;
+    // anything longer than 18 digits may not fit in 64 bits
+    if (t.name.size() > 18) {
+      return make_bignum(bignum_from_string(t.name));
+    }
+    return make_integer(std::stoll(t.name));
     break;
   }
     
   case TOKEN_FLOAT: {
     double ddouble = std::stod(t.name);
-    Parse_Node *ffloat = new Parse_Node{PARSE_NODE_LITERAL, LITERAL_FLOAT};
-    ffloat->val.dub = ddouble;
-    ffloat->token = t;
-    ffloat->nesting_depth = current_depth;
+    Parse_Node *ffloat = make_float(ddouble);
+    set_source_location(ffloat, file_name, t);
     return ffloat;
     break;
   }
@@ -163,10 +178,8 @@ Parse_Node *Parser::parse_next_token() {
 
 Parse_Node *Parser::parse_list(Token start) {
   Parse_Node *list = new Parse_Node{PARSE_NODE_LIST};
-  list->nesting_depth = current_depth;
-  list->token = start;
+  set_source_location(list, file_name, start);
   Token t = lex.peek_next_token();
-  current_depth++;
   Parse_Node *cur = list;
   Parse_Node *next;
   while (t.type != TOKEN_R_PAREN) {
@@ -177,95 +190,295 @@ Parse_Node *Parser::parse_list(Token start) {
     }
 
     cur->first = parse_next_token();
+    if (node_subtype(cur->first) == SYNTAX_COMMA_AT) {
+      list->flags |= NODE_HAS_SPLICE;
+    }
     next = new Parse_Node{PARSE_NODE_LIST};
     cur->next = next;
     cur = next;
     t = lex.peek_next_token();    
   }
-  current_depth--;
   lex.next_token(); // eat right parenthesis
   return list;
 }
 
+// the literal holds the element forms, evaluating it builds a new vector
+Parse_Node *Parser::parse_vector(Token start) {
+  Parse_Node *vec = make_vector();
+  set_source_location(vec, file_name, start);
+  Token t = lex.peek_next_token();
+  while (t.type != TOKEN_R_BRACKET) {
+    if (t.type == TOKEN_END_OF_FILE) {
+      std::cerr << "Unmatched '[' at " << lex.filename << ":" << t.start_line << ":" << t.start_char << std::endl;
+      exit(1);
+    }
+    vector_value(vec).push_back(parse_next_token());
+    t = lex.peek_next_token();
+  }
+  lex.next_token(); // eat right bracket
+  return vec;
+}
+
+struct List_Header {
+  int length;
+  uint32_t epoch;  // headers from before the last invalidate_list_headers are redone
+  Parse_Node *end;  // the empty cell that ends the list
+};
+
+static std::unordered_map<const Parse_Node *, List_Header> list_headers;
+static uint32_t list_header_epoch = 0;
+
+// nullptr if list has no header
+static List_Header *list_header(Parse_Node *list) {
+  if (!(list->flags & NODE_HAS_HEADER)) {
+    return nullptr;
+  }
+  List_Header &h = list_headers.at(list);
+  if (h.epoch != list_header_epoch) {
+    h = List_Header{0, list_header_epoch, list};
+  }
+  // appended to through another cell
+  while (h.end->first != nullptr) {
+    h.end = h.end->next;
+    h.length++;
+  }
+  return &h;
+}
+
+static void set_list_header(Parse_Node *list, int length, Parse_Node *end) {
+  list->flags |= NODE_HAS_HEADER;
+  list_headers[list] = List_Header{length, list_header_epoch, end};
+}
+
+void invalidate_list_headers() {
+  list_header_epoch++;
+}
+
+void forget_list_header(const Parse_Node *node) {
+  list_headers.erase(node);
+}
+
 int Parse_Node::length() {
   if (type != PARSE_NODE_LIST) {
     fprintf(stderr, "Error: called length on object that is not a list\n");
     return 0;
   }
 
+  List_Header *h = list_header(this);
+  if (h != nullptr) {
+    return h->length;
+  }
   int len = 0;
   Parse_Node *cur = this;
   while (cur->first != nullptr) {
     ++len;
     cur = cur->next;
   }
+  if (len >= LIST_HEADER_MIN) {
+    set_list_header(this, len, cur);
+  }
   return len;  
 }
 
-std::string Parse_Node::print() {
-  switch (type) {
-  case PARSE_NODE_LIST: {
-    std::string list = "(";
-    Parse_Node *cur = this;
-    while (cur->first != nullptr) {
-      list += cur->first->print();
-      if (cur->next->first != nullptr) {
-	list += " ";
-      }
-      cur = cur->next;
-    }
-    list += ")";
-    return list;
+void list_append(Parse_Node *list, Parse_Node *value) {
+  Parse_Node *next = new Parse_Node{PARSE_NODE_LIST};
+  List_Header *h = list_header(list);
+  if (h != nullptr) {
+    h->end->first = value;
+    h->end->next = next;
+    h->end = next;
+    h->length++;
+    return;
+  }
+  int len = 0;
+  Parse_Node *end = list;
+  while (end->first != nullptr) {
+    ++len;
+    end = end->next;
+  }
+  end->first = value;
+  end->next = next;
+  if (len + 1 >= LIST_HEADER_MIN) {
+    set_list_header(list, len + 1, next);
   }
+}
+
+// the new cell shares list's end, so it inherits the header
+Parse_Node *list_push(Parse_Node *value, Parse_Node *list) {
+  Parse_Node *ret = new Parse_Node{PARSE_NODE_LIST};
+  ret->first = value;
+  ret->next = list;
+  List_Header *h = list_header(list);
+  if (h != nullptr) {
+    set_list_header(ret, h->length + 1, h->end);
+  }
+  return ret;
+}
+
+Parse_Node *list_pop(Parse_Node *list) {
+  Parse_Node *rest = list->next;
+  List_Header *h = list_header(list);
+  if (h != nullptr && h->length - 1 >= LIST_HEADER_MIN) {
+    set_list_header(rest, h->length - 1, h->end);
+  }
+  return rest;
+}
 
+static std::unordered_map<std::string, uint32_t> symbol_ids;
+static std::deque<std::string> symbol_names;
+
+uint32_t intern_symbol(const std::string &name) {
+  auto it = symbol_ids.find(name);
+  if (it != symbol_ids.end()) {
+    return it->second;
+  }
+  uint32_t id = symbol_names.size();
+  symbol_names.push_back(name);
+  symbol_ids.emplace(name, id);
+  return id;
+}
+
+const std::string &interned_name(uint32_t id) {
+  return symbol_names[id];
+}
+
+Parse_Node *make_symbol(const std::string &name) {
+  Parse_Node *sym = new Parse_Node{PARSE_NODE_SYMBOL};
+  if (name[0] == ':') {
+    sym->subtype = SYMBOL_KEYWORD;
+  }
+  sym->aux = intern_symbol(name);
+  return sym;
+}
+
+Parse_Node *make_string(const std::string &value) {
+  Parse_Node *str = new Parse_Node{PARSE_NODE_LITERAL, LITERAL_STRING};
+  str->val.str = new std::string(value);
+  return str;
+}
+
+Parse_Node *make_float(double value) {
+  Parse_Node *f = new Parse_Node{PARSE_NODE_LITERAL, LITERAL_FLOAT};
+  f->val.dub = value;
+  return f;
+}
+
+Parse_Node *make_vector(size_t size) {
+  Parse_Node *vec = new Parse_Node{PARSE_NODE_VECTOR};
+  vec->val.vec = new std::vector<Parse_Node *>(size);
+  return vec;
+}
+
+static std::set<std::string> file_names;
+static std::unordered_map<const Parse_Node *, Source_Location> source_locations;
+
+const std::string *intern_file_name(const std::string &file) {
+  return &*file_names.insert(file).first;
+}
+
+void set_source_location(Parse_Node *node, const std::string *file, const Token &t) {
+  source_locations[node] = Source_Location{file, t.start_line, t.start_char};
+  node->flags |= NODE_HAS_LOCATION;
+}
+
+const Source_Location *source_location(const Parse_Node *node) {
+  if (is_fixnum(node) || !(node->flags & NODE_HAS_LOCATION)) {
+    return nullptr;
+  }
+  return &source_locations.at(node);
+}
+
+void forget_source_location(const Parse_Node *node) {
+  source_locations.erase(node);
+}
+
+Parse_Node *make_integer(int64_t value) {
+  if (value >= FIXNUM_MIN && value <= FIXNUM_MAX) {
+    return make_fixnum(value);
+  }
+  Parse_Node *integer = new Parse_Node{PARSE_NODE_LITERAL, LITERAL_INTEGER};
+  integer->val.u64 = value;
+  return integer;
+}
+
+static const char *syntax_prefix(Parse_Node_Subtype subtype) {
+  switch (subtype) {
+  case SYNTAX_QUOTE: return "'";
+  case SYNTAX_BACKTICK: return "`";
+  case SYNTAX_COMMA: return ",";
+  case SYNTAX_COMMA_AT: return ",@";
+  default: return nullptr;
+  }
+}
+
+// everything but lists and syntax
+static void print_atom(std::string &out, Parse_Node *node) {
+  if (is_fixnum(node)) {
+    out += std::to_string(fixnum_value(node));
+    return;
+  }
+
+  switch (node->type) {
   case PARSE_NODE_SYMBOL: {
-    return token.name;
+    out += symbol_name(node);
+    return;
   }
     
   case PARSE_NODE_LITERAL: {
-    switch (subtype) {
+    switch (node->subtype) {
     case LITERAL_INTEGER: {
-      return std::to_string(val.u64);
+      out += std::to_string(node->val.u64);
+      return;
+    }
+    case LITERAL_BIGNUM: {
+      out += bignum_to_string(bignum_value(node));
+      return;
     }
     case LITERAL_FLOAT: {
-      return std::to_string(val.dub);     
+      out += std::to_string(node->val.dub);     
+      return;
     }
       
     case LITERAL_BOOLEAN: {
-      return (val.b ? "true" : "false");
+      out += (node->val.b ? "true" : "false");
+      return;
     }
     case LITERAL_STRING: {
-      return token.name;
+      out += string_value(node);
+      return;
     }
     }
   }
   case PARSE_NODE_FUNCTION: {
-    return "#'" + token.name;
-    break;
+    out += "#'" + symbol_name(node);
+    return;
   }
-  case PARSE_NODE_SYNTAX: {
-    switch (subtype) {
-    case SYNTAX_QUOTE: {
-      return "'" + first->print();      
-      break;
-    }
-    case SYNTAX_BACKTICK: {
-      return "`" + first->print();      
-      break;
-    }
-    case SYNTAX_COMMA: {
-      return "," + first->print();      
-      break;
-    }
-    case SYNTAX_COMMA_AT: {
-      return ",@" + first->print();      
-      break;
+    
+  case PARSE_NODE_HASH: {
+    out += "#<hash " + std::to_string(node->val.hash->size()) + ">";
+    return;
+  }
+
+  case PARSE_NODE_ARRAY: {
+    if (node->subtype == ARRAY_INT64) {
+      out += "#i64[";
+      for (size_t i = 0; i < node->val.ints->size(); i++) {
+	out += (i > 0 ? " " : "") + std::to_string((*node->val.ints)[i]);
+      }
+    } else {
+      out += "#f64[";
+      for (size_t i = 0; i < node->val.floats->size(); i++) {
+	out += (i > 0 ? " " : "") + std::to_string((*node->val.floats)[i]);
+      }
     }
-    }    
+    out += "]";
+    return;
   }
-    
+
+  case PARSE_NODE_SYNTAX:
   case PARSE_NODE_ERROR: {
-    return "[ERROR]";   
+    out += "[ERROR]";   
+    return;
   }
     
   default:
@@ -274,18 +487,84 @@ std::string Parse_Node::print() {
   }
 }
 
-void Parse_Node::debug_print_parse_node() {
+// Iterative, open_lists holds the rest of every list being printed, so
+// deeply nested data doesn't use up the native stack.
+std::string print_node(Parse_Node *node) {
+  std::string out;
+  std::vector<Parse_Node *> open_lists;
+  while (true) {
+    // print node, or open it if it's a list
+    while (true) {
+      if (!is_fixnum(node) && node->type == PARSE_NODE_SYNTAX && syntax_prefix(node->subtype)) {
+	out += syntax_prefix(node->subtype);
+	node = node->first;
+	continue;
+      }
+      if (!is_fixnum(node) && node->type == PARSE_NODE_VECTOR) {
+	out += "[";
+	std::vector<Parse_Node *> &elements = vector_value(node);
+	for (size_t i = 0; i < elements.size(); i++) {
+	  if (i > 0) {
+	    out += " ";
+	  }
+	  out += print_node(elements[i]);
+	}
+	out += "]";
+	break;
+      }
+      if (!is_fixnum(node) && node->type == PARSE_NODE_LIST) {
+	out += "(";
+	if (node->first != nullptr) {
+	  open_lists.push_back(node->next);
+	  node = node->first;
+	  continue;
+	}
+	out += ")";
+	break;
+      }
+      print_atom(out, node);
+      break;
+    }
+
+    // move on to the next element of the innermost open list
+    while (true) {
+      if (open_lists.empty()) {
+	return out;
+      }
+      Parse_Node *rest = open_lists.back();
+      if (rest->first != nullptr) {
+	out += " ";
+	open_lists.back() = rest->next;
+	node = rest->first;
+	break;
+      }
+      open_lists.pop_back();
+      out += ")";
+    }
+  }
+}
 
-  for(int i = 0; i < nesting_depth; i++) printf("  ");
+void Parse_Node::debug_print_parse_node(int depth) {
+
+  for(int i = 0; i < depth; i++) printf("  ");
   
   printf("Parse_Node type: %s", parse_node_types[type]);
+  const Source_Location *loc = source_location(this);
+  if (loc != nullptr) {
+    printf(" at %s:%d:%d", loc->file->c_str(), loc->line, loc->column);
+  }
   if (type != PARSE_NODE_LIST) {
-    std::cout << ", name: " << token.name << "\n";;
+    std::cout << ", value: " << print_node(this) << "\n";;
   } else {
     printf("\n");
     Parse_Node *cur = this;
     while (cur->first != nullptr) {
-      cur->debug_print_parse_node();
+      if (is_fixnum(cur->first)) {
+	for(int i = 0; i <= depth; i++) printf("  ");
+	printf("Parse_Node type: %s, value: %s\n", parse_node_types[PARSE_NODE_LITERAL], print_node(cur->first).c_str());
+      } else {
+	cur->first->debug_print_parse_node(depth + 1);
+      }
       cur = cur->next;
     }    
   } 
@@ -5,21 +5,29 @@
 #include <map>
 
 #include "lexer.h"
+#include "gc.h"
 
 struct Symbol_Table;
+struct Lambda_List;
+struct Value_Builtin;
+struct Hash_Table;
+struct Bignum;
 
-enum Parse_Node_Type {
+enum Parse_Node_Type : uint8_t {
   PARSE_NODE_LIST,
   PARSE_NODE_SYMBOL,
   PARSE_NODE_LITERAL,
   PARSE_NODE_FUNCTION,
   PARSE_NODE_SYNTAX,
-  PARSE_NODE_ERROR
+  PARSE_NODE_ERROR,
+  PARSE_NODE_VECTOR,
+  PARSE_NODE_HASH,
+  PARSE_NODE_ARRAY
 };
 
 std::string print_parse_node_type(Parse_Node_Type);
 
-enum Parse_Node_Subtype {
+enum Parse_Node_Subtype : uint8_t {
   SUBTYPE_NONE,
   
   SYMBOL_KEYWORD,
@@ -31,6 +39,7 @@ enum Parse_Node_Subtype {
   LITERAL_FLOAT,
   LITERAL_STRING,
   LITERAL_BOOLEAN,
+  LITERAL_BIGNUM,
 
   FUNCTION_MACRO,
   FUNCTION_BUILTIN,
@@ -40,65 +49,258 @@ enum Parse_Node_Subtype {
   SYNTAX_BACKTICK,
   SYNTAX_COMMA,
   SYNTAX_COMMA_AT,
+
+  ARRAY_INT64,
+  ARRAY_FLOAT64,
+};
+
+enum Parse_Node_Flags : uint16_t {
+  NODE_HAS_LOCATION = 1 << 0,  // the node has an entry in the source location table
+  NODE_LEXICAL_ADDRESS = 1 << 1,  // symbol whose val holds a lexical address, see resolve.h
+  NODE_STRICT_BUILTIN = 1 << 2,  // builtin that evaluates every argument once, in order
+  NODE_HAS_CHUNK = 1 << 3,  // function with an entry in the vm's chunk table
+  NODE_HAS_CLOSURE = 1 << 4,  // function with an entry in the closure compiler's table
+  NODE_HAS_SPLICE = 1 << 5,  // parsed list with a ,@ element, see has_splice
+  NODE_HAS_EXPANSION = 1 << 6,  // macro call with a cached expansion, see expand_macro
+  NODE_HAS_TEMPLATE = 1 << 7,  // backtick with a compiled template, see backtick.h
+  NODE_HAS_LAMBDA_LIST = 1 << 8,  // parameter list whose val owns its Lambda_List, see interp.h
+  NODE_VALUE_BUILTIN = 1 << 9,  // builtin called with evaluated arguments, see interp.h
+  NODE_HAS_HEADER = 1 << 10,  // list with a cached length and end, see list_append
+  NODE_GLOBAL_OPERATOR = 1 << 11,  // call in a function body whose operator no frame binds, see resolve.h
 };
 
+// Kept at 32 bytes, every cons cell is one of these. Names and source
+// positions live in side tables: symbols and functions store their interned
+// name id in aux, nodes built by the parser have NODE_HAS_LOCATION set.
 struct Parse_Node {
   Parse_Node_Type type;
   Parse_Node_Subtype subtype = SUBTYPE_NONE;
-  Token token;
+  uint16_t flags = 0;
+  uint32_t aux = 0;
   
   union {
     bool b;
     int64_t u64;
     double dub;
+    std::string *str;   // owned, freed by the collector
+    std::vector<Parse_Node *> *vec;  // owned, freed by the collector
+    Hash_Table *hash;  // owned, freed by the collector
+    std::vector<int64_t> *ints;  // ARRAY_INT64, owned, freed by the collector
+    std::vector<double> *floats;  // ARRAY_FLOAT64, owned, freed by the collector
+    Bignum *big;  // LITERAL_BIGNUM, owned, freed by the collector
+    Symbol_Table *env;  // definition environment of native functions and macros
     Parse_Node *(*func)(Parse_Node *, Symbol_Table *);
+    Parse_Node *callee;  // call sites: cached operator, valid while aux == definition_epoch
+    Lambda_List *lambda_list;  // parameter lists with NODE_HAS_LAMBDA_LIST
+    const Value_Builtin *builtin;  // builtins with NODE_VALUE_BUILTIN
   } val;
 
   Parse_Node *first = nullptr;
-  Parse_Node *next;
-  
-  int nesting_depth = 0;
+  Parse_Node *next = nullptr;
+
+  // nodes live on the collected heap, see gc.h
+  static void *operator new(size_t size) { return gc_alloc(size, GC_NODE); }
+  static void operator delete(void *) {}
   
-  std::string print();
-  void debug_print_parse_node();
+  void debug_print_parse_node(int depth = 0);
   std::string print_type();
   std::string print_subtype();
   int length();
 };
 
+static_assert(sizeof(Parse_Node) == 32, "Parse_Node should stay 32 bytes");
+
+// Symbol names are interned, each distinct name gets a small integer id.
+// The returned references stay valid for the life of the program.
+uint32_t intern_symbol(const std::string &name);
+const std::string &interned_name(uint32_t id);
+
+Parse_Node *make_symbol(const std::string &name);
+Parse_Node *make_string(const std::string &value);
+Parse_Node *make_float(double value);
+// a vector of size elements, all nullptr until they're filled in
+Parse_Node *make_vector(size_t size = 0);
+
+// name of a symbol or function node
+inline const std::string &symbol_name(const Parse_Node *node) {
+  return interned_name(node->aux);
+}
+
+inline std::string &string_value(Parse_Node *node) {
+  return *node->val.str;
+}
+
+inline std::vector<Parse_Node *> &vector_value(Parse_Node *node) {
+  return *node->val.vec;
+}
+
+// Lists are chains of cells ending in an empty one, and every cell is also
+// the list of the elements from it on. A list of at least LIST_HEADER_MIN
+// elements gets a header in a side table the first time it's measured or
+// appended to, holding its length and its empty end cell, so length and
+// append don't walk it. Shorter lists are walked, that's cheaper than the
+// lookup. Appending through another cell of the same list leaves the
+// header's end cell non-empty, and the header catches up from there the
+// next time it's used.
+const int LIST_HEADER_MIN = 16;
+
+// adds value to the end of list in place, the empty end cell becomes the
+// value's cell
+void list_append(Parse_Node *list, Parse_Node *value);
+// a new cell holding value in front of list
+Parse_Node *list_push(Parse_Node *value, Parse_Node *list);
+// list without its first element, list must not be empty
+Parse_Node *list_pop(Parse_Node *list);
+// must be called after unlinking cells from the middle of a list, it
+// throws away every header
+void invalidate_list_headers();
+void forget_list_header(const Parse_Node *node);
+
+struct Source_Location {
+  const std::string *file;
+  int line;
+  int column;
+};
+
+// file names are interned too so locations outlive their Parser
+const std::string *intern_file_name(const std::string &file);
+void set_source_location(Parse_Node *node, const std::string *file, const Token &t);
+// returns nullptr for nodes that weren't built by the parser
+const Source_Location *source_location(const Parse_Node *node);
+void forget_source_location(const Parse_Node *node);
+
+// Integers that fit in 63 bits are immediates, the value is stored in the
+// pointer itself shifted left with the low bit set, so arithmetic doesn't
+// allocate. A fixnum must never be dereferenced: code that looks inside a
+// value goes through node_type, node_subtype and integer_value, or checks
+// is_fixnum first.
+const int64_t FIXNUM_MAX = INT64_MAX >> 1;
+const int64_t FIXNUM_MIN = INT64_MIN >> 1;
+
+inline bool is_fixnum(const Parse_Node *node) {
+  return ((uintptr_t)node & 1) != 0;
+}
+
+inline int64_t fixnum_value(const Parse_Node *node) {
+  return ((intptr_t)node) >> 1;
+}
+
+inline Parse_Node *make_fixnum(int64_t value) {
+  return (Parse_Node *)(((uintptr_t)value << 1) | 1);
+}
+
+inline Parse_Node_Type node_type(const Parse_Node *node) {
+  return is_fixnum(node) ? PARSE_NODE_LITERAL : node->type;
+}
+
+inline Parse_Node_Subtype node_subtype(const Parse_Node *node) {
+  return is_fixnum(node) ? LITERAL_INTEGER : node->subtype;
+}
+
+// node must be an integer, either a fixnum or a boxed LITERAL_INTEGER
+inline int64_t integer_value(const Parse_Node *node) {
+  return is_fixnum(node) ? fixnum_value(node) : node->val.u64;
+}
+
+// only boxes values outside of the fixnum range
+Parse_Node *make_integer(int64_t value);
+
+std::string print_node(Parse_Node *node);
+
 struct Parser {
   std::vector<Parse_Node*> top_level_expressions = {};
-  Parse_Node current;
   Lexer lex;
-
-  int current_depth = 0;
+  const std::string *file_name;
 
   Parser(const char* file) {
     lex = Lexer(file);
+    file_name = intern_file_name(lex.filename);
+    gc_add_root(&top_level_expressions);
   }
 
   Parser() {
     lex = Lexer();
     lex.filename = "repl";
+    file_name = intern_file_name(lex.filename);
+    gc_add_root(&top_level_expressions);
+  }
+
+  ~Parser() {
+    gc_remove_root(&top_level_expressions);
   }
 
+  Parser(const Parser &) = delete;
+  Parser &operator=(const Parser &) = delete;
+
   Parse_Node *parse_text(std::string input);
   void parse_top_level_expressions();
   Parse_Node *parse_next_token();
   Parse_Node *parse_list(Token start);
+  Parse_Node *parse_vector(Token start);
 };
 
+// Bumped whenever a global binding to a function may have changed: by
+// defun, defmacro and defsym, and by set when the old or new value of a
+// global is a function. Call sites cache the function their operator names
+// together with the epoch it was looked up in. Starts at 1 so the zero aux
+// of a fresh list never matches.
+extern uint32_t definition_epoch;
+
+// The global table (no parent) is an open addressing hash table keyed by
+// interned symbol id, with linear probing. Every other table is a frame:
+// the bindings of a function call, let or for-each, stored as a flat array
+// in the order they were bound so a lexical address can index it directly.
+// Frames usually hold a handful of bindings, those fit in the inline
+// entries and never touch malloc.
 struct Symbol_Table {
+  static const uint32_t EMPTY = UINT32_MAX;
+  static const uint32_t INLINE_CAPACITY = 4;
+
+  struct Entry {
+    uint32_t id;
+    Parse_Node *value;
+  };
 
-  std::map<std::string, Parse_Node *> table;
+  Entry *entries = inline_entries;
+  uint32_t capacity = INLINE_CAPACITY;
+  uint32_t count = 0;
   Symbol_Table *parent_table = nullptr;
+  Entry inline_entries[INLINE_CAPACITY] = {{EMPTY}, {EMPTY}, {EMPTY}, {EMPTY}};
 
   Symbol_Table() {}
   Symbol_Table(Symbol_Table *parent) {
     parent_table = parent;
   }
-  
-  void insert(std::string symbol, Parse_Node *node);
-  Parse_Node *lookup(std::string symbol);
-  Parse_Node *set(std::string symbol, Parse_Node *node);
+  ~Symbol_Table() {
+    if (entries != inline_entries) {
+      delete[] entries;
+    }
+  }
+  Symbol_Table(const Symbol_Table &) = delete;
+  Symbol_Table &operator=(const Symbol_Table &) = delete;
+
+  static void *operator new(size_t size) { return gc_alloc(size, GC_TABLE); }
+  static void operator delete(void *) {}
+
+  // binds id in this table, insert keeps an existing binding, define replaces it
+  void insert(uint32_t id, Parse_Node *node);
+  void define(uint32_t id, Parse_Node *node);
+  // this table only, nullptr if unbound
+  Parse_Node *find(uint32_t id);
+  // walks the parent tables, throws if unbound
+  Parse_Node *lookup(uint32_t id);
+  // walks the parent tables, nullptr if unbound
+  Parse_Node *bound_value(uint32_t id);
+  // address is (depth << 32 | index), falls back to bound_value(id) if the
+  // frame at that address doesn't hold id
+  Parse_Node *bound_value(uint32_t id, uint64_t address);
+  // rebinds the innermost existing binding
+  Parse_Node *set(uint32_t id, Parse_Node *node);
+
+  bool is_frame() { return parent_table != nullptr; }
+
+private:
+  Entry *slot(uint32_t id);
+  Entry *find_entry(uint32_t id);
+  void grow();
 };
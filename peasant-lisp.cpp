@@ -1,31 +1,92 @@
 #include <cstdio>
 #include <cerrno>
+#include <cstdlib>
 #include <iostream>
 
 #include "lexer.h"
 #include "parser.h"
 #include "interp.h"
+#include "vm.h"
+#include "closure.h"
+#include "fold.h"
+#include "array_kernels.h"
+#include "interp_exceptions.h"
+
+void print_usage(const char *program) {
+  printf("usage: %s [--allocator=slab|malloc] [--engine=closure|tree|vm] [--max-depth=N] [--array-kernels=avx2|scalar] [--report-inlining] [source-file]\n", program);
+}
+
+Parse_Node *evaluate(Parse_Node *form, Symbol_Table *env) {
+  Parse_Node *ret;
+  try {
+    form = fold_constants(form, env);
+    ret = (engine == ENGINE_VM) ? vm_eval(form, env) : eval_parse_node(form, env);
+  } catch (stackExhausted &e) {
+    return error_value(e.what());
+  }
+  // a return outside of any function ends the top level form
+  if (is_return(ret)) {
+    return take_return();
+  }
+  return ret;
+}
 
 int main(int argc, char *argv[]) {
+  gc_init(__builtin_frame_address(0));
 
-  if (argc == 2) {
-    if (argv[1] == "--help" || argv[1] == "-h") {    
-      printf("usage: %s [source-file]\n", argv[0]);
+  const char *source_file = nullptr;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--help" || arg == "-h") {
+      print_usage(argv[0]);
       return 1;
+    } else if (arg == "--allocator=slab") {
+      gc_set_allocator(GC_ALLOCATOR_SLAB);
+    } else if (arg == "--allocator=malloc") {
+      gc_set_allocator(GC_ALLOCATOR_MALLOC);
+    } else if (arg == "--engine=closure") {
+      engine = ENGINE_CLOSURE;
+    } else if (arg == "--engine=tree") {
+      engine = ENGINE_TREE;
+    } else if (arg == "--engine=vm") {
+      vm_init();
+    } else if (arg.rfind("--array-kernels=", 0) == 0) {
+      if (!select_array_kernels(arg.c_str() + 16)) {
+	print_usage(argv[0]);
+	return 1;
+      }
+    } else if (arg == "--report-inlining") {
+      report_inlining = true;
+    } else if (arg.rfind("--max-depth=", 0) == 0) {
+      char *end;
+      unsigned long depth = strtoul(arg.c_str() + 12, &end, 10);
+      if (*end != '\0' || depth == 0 || depth > UINT32_MAX) {
+	print_usage(argv[0]);
+	return 1;
+      }
+      max_call_depth = depth;
+    } else if (arg[0] == '-' || source_file != nullptr) {
+      print_usage(argv[0]);
+      return 1;
+    } else {
+      source_file = argv[i];
     }
-    Symbol_Table env = create_base_environment();
-    Parser parse = Parser(argv[1]);
+  }
+
+  if (source_file != nullptr) {
+    Symbol_Table *env = create_base_environment();
+    Parser parse = Parser(source_file);
 
     parse.parse_top_level_expressions();
 
     for (int i = 0; i < parse.top_level_expressions.size(); i++) {
       // parse.top_level_expressions[i].debug_print_parse_node();
       printf("> ");
-      std::cout << parse.top_level_expressions[i]->print();
+      std::cout << print_node(parse.top_level_expressions[i]);
       printf("\n");
-      Parse_Node *evaled = eval_parse_node(parse.top_level_expressions[i], &env);
+      Parse_Node *evaled = evaluate(parse.top_level_expressions[i], env);
       if (evaled != nullptr) {
-	std::cout << "\E[31m" << evaled->print() << "\E[39m" << std::endl;
+	std::cout << "\E[31m" << print_node(evaled) << "\E[39m" << std::endl;
       }
       printf("\n");
     }
@@ -33,7 +94,7 @@ int main(int argc, char *argv[]) {
   }
 
   // start repl
-  Symbol_Table env = create_base_environment();
+  Symbol_Table *env = create_base_environment();
   Parser parse = Parser();
 
   while (true) {
@@ -42,10 +103,10 @@ int main(int argc, char *argv[]) {
     // std::cin.ignore();
     getline(std::cin, input);
     Parse_Node *tree = parse.parse_text(input);    
-    Parse_Node *evaled = eval_parse_node(tree, &env);
+    Parse_Node *evaled = evaluate(tree, env);
     if (!is_error(evaled)) {
       std::cout << "\e[31m"
-		<< evaled->print() << "\e[39m"
+		<< print_node(evaled) << "\e[39m"
 		<< std::endl;
     } else {
       std::cout << std::endl;
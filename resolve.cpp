@@ -0,0 +1,211 @@
+#include "resolve.h"
+#include "interp.h"
+#include "builtin_helpers.h"
+#include "builtin_hash.h"
+
+uint64_t lexical_address(uint32_t depth, uint32_t index) {
+  return ((uint64_t)depth << 32) | index;
+}
+
+struct Resolver {
+  // ids bound by each frame, in binding order, innermost last
+  std::vector<std::vector<uint32_t>> frames;
+  Symbol_Table *env;
+  bool top_level;  // env is the global table, there are no frames outside frames
+
+  void bind(uint32_t id);
+  void resolve_symbol(Parse_Node *sym);
+  void resolve_form(Parse_Node *node);
+  void resolve_forms(Parse_Node *list);
+  void resolve_let(Parse_Node *args);
+  void resolve_for_each(Parse_Node *args);
+  void resolve_hash_for_each(Parse_Node *args);
+  bool is_local(uint32_t id);
+};
+
+void Resolver::bind(uint32_t id) {
+  std::vector<uint32_t> &frame = frames.back();
+  for (uint32_t bound : frame) {
+    if (bound == id) {
+      return;
+    }
+  }
+  frame.push_back(id);
+}
+
+bool Resolver::is_local(uint32_t id) {
+  for (auto &frame : frames) {
+    for (uint32_t bound : frame) {
+      if (bound == id) {
+	return true;
+      }
+    }
+  }
+  return false;
+}
+
+void Resolver::resolve_symbol(Parse_Node *sym) {
+  if (is_keyword(sym)) {
+    return;
+  }
+  for (size_t depth = 0; depth < frames.size(); depth++) {
+    std::vector<uint32_t> &frame = frames[frames.size() - 1 - depth];
+    for (size_t index = 0; index < frame.size(); index++) {
+      if (frame[index] == sym->aux) {
+	sym->flags |= NODE_LEXICAL_ADDRESS;
+	sym->val.u64 = lexical_address(depth, index);
+	return;
+      }
+    }
+  }
+}
+
+void Resolver::resolve_forms(Parse_Node *list) {
+  while (!is_empty_list(list)) {
+    resolve_form(list->first);
+    list = list->next;
+  }
+}
+
+// (let ((sym val) sym ...) body...), values see the bindings before them
+void Resolver::resolve_let(Parse_Node *args) {
+  if (is_empty_list(args) || !is_list(args->first)) {
+    return;
+  }
+  frames.push_back({});
+  Parse_Node *defs = args->first;
+  while (!is_empty_list(defs)) {
+    Parse_Node *let_form = defs->first;
+    if (is_list(let_form) && !is_empty_list(let_form) && is_sym(let_form->first)) {
+      if (!is_empty_list(let_form->next)) {
+	resolve_form(let_form->next->first);
+      }
+      bind(let_form->first->aux);
+    } else if (is_sym(let_form)) {
+      bind(let_form->aux);
+    }
+    defs = defs->next;
+  }
+  resolve_forms(args->next);
+  frames.pop_back();
+}
+
+// (for-each (sym list) body...), list is evaluated outside the new frame
+void Resolver::resolve_for_each(Parse_Node *args) {
+  Parse_Node *binding = args->first;
+  if (!is_list(binding) || binding->length() != 2 || !is_sym(binding->first)) {
+    return;
+  }
+  resolve_form(binding->next->first);
+  frames.push_back({binding->first->aux});
+  resolve_forms(args->next);
+  frames.pop_back();
+}
+
+// (hash-for-each (key value table) body...), the same with two variables
+void Resolver::resolve_hash_for_each(Parse_Node *args) {
+  Parse_Node *binding = args->first;
+  if (!is_list(binding) || binding->length() != 3 ||
+      !is_sym(binding->first) || !is_sym(binding->next->first)) {
+    return;
+  }
+  resolve_form(binding->next->next->first);
+  frames.push_back({});
+  bind(binding->first->aux);
+  bind(binding->next->first->aux);
+  resolve_forms(args->next);
+  frames.pop_back();
+}
+
+void Resolver::resolve_form(Parse_Node *node) {
+  // addresses are only hints, a form nested too deep to walk is left to be
+  // looked up by name
+  if (stack_exhausted()) {
+    return;
+  }
+  switch (node_type(node)) {
+  case PARSE_NODE_SYMBOL: {
+    resolve_symbol(node);
+    return;
+  }
+  case PARSE_NODE_LIST: {
+    if (is_empty_list(node) || !is_sym(node->first)) {
+      return;
+    }
+    // a splice changes the shape of the call at run time
+    if (has_splice(node)) {
+      return;
+    }
+
+    // only calls to something already defined can be trusted not to be a
+    // macro that binds variables of its own
+    uint32_t op = node->first->aux;
+    Parse_Node *func = is_local(op) ? nullptr : env->bound_value(op);
+    if (func == nullptr || node_type(func) != PARSE_NODE_FUNCTION) {
+      return;
+    }
+    if (top_level) {
+      node->flags |= NODE_GLOBAL_OPERATOR;
+    }
+    Parse_Node *args = node->next;
+    switch (node_subtype(func)) {
+    case FUNCTION_NATIVE:
+      resolve_forms(args);
+      return;
+    case FUNCTION_BUILTIN: {
+      auto builtin = forms_func(func);
+      if (builtin == builtin_let) {
+	resolve_let(args);
+      } else if (builtin == builtin_for_each) {
+	resolve_for_each(args);
+      } else if (builtin == builtin_hash_for_each) {
+	resolve_hash_for_each(args);
+      } else if (builtin != builtin_quote && builtin != builtin_defun &&
+		 builtin != builtin_defmacro && builtin != builtin_expand &&
+		 builtin != builtin_inspect_macro) {
+	resolve_forms(args);
+      }
+      return;
+    }
+    default:
+      return;
+    }
+  }
+  case PARSE_NODE_VECTOR: {
+    for (Parse_Node *element : vector_value(node)) {
+      resolve_form(element);
+    }
+    return;
+  }
+  default:
+    return;
+  }
+}
+
+void resolve_function(Parse_Node *fun, Symbol_Table *env) {
+  Resolver resolver;
+  resolver.env = env;
+  resolver.top_level = !env->is_frame();
+
+  // mirrors the order bind_arguments binds the parameters in
+  const Lambda_List *params = lambda_list(fun);
+  resolver.frames.push_back({});
+  for (uint32_t id : params->required) {
+    resolver.bind(id);
+  }
+  for (uint32_t id : params->optional) {
+    resolver.bind(id);
+  }
+  if (params->rest != Symbol_Table::EMPTY) {
+    resolver.bind(params->rest);
+  }
+
+  // defaults of optional parameters are evaluated in the new frame
+  for (Parse_Node *form : params->defaults) {
+    if (form != nullptr) {
+      resolver.resolve_form(form);
+    }
+  }
+
+  resolver.resolve_forms(fun->next);
+}
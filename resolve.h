@@ -0,0 +1,25 @@
+#pragma once
+#include "parser.h"
+
+// Lexical addressing for function and macro bodies.
+//
+// Every function call, let, for-each and hash-for-each binds its variables
+// in a frame, a Symbol_Table holding them in a flat array (see parser.h).
+// When a function is defined its body is walked once and each reference to
+// one of its own parameters or to a variable bound inside it is tagged with
+// NODE_LEXICAL_ADDRESS and the address (depth << 32 | index) in val. Depth
+// counts frames outwards from the one the reference is evaluated in.
+//
+// Addresses are hints: eval checks the frame at the address really binds the
+// symbol and falls back to walking the frames by name otherwise. Macro calls,
+// quoted and backticked forms, splices and nested defuns are not descended
+// into, their symbols are always looked up by name.
+//
+// Calls whose operator isn't bound by any frame of a function defined at
+// top level are tagged with NODE_GLOBAL_OPERATOR, the call site cache can
+// skip searching the frames for them.
+
+uint64_t lexical_address(uint32_t depth, uint32_t index);
+
+// fun is a FUNCTION_NATIVE or FUNCTION_MACRO node, env is where it is defined
+void resolve_function(Parse_Node *fun, Symbol_Table *env);
@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "slab.h"
+
+Slab_Stats slab_stats;
+
+const int SLAB_CLASSES = 16;
+static const uint32_t class_sizes[SLAB_CLASSES] = {
+  16, 32, 48, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 448, 512
+};
+
+struct Slab {
+  Slab *next;              // next slab of the same size class
+  uint32_t size_class;
+  uint32_t slot_size;
+  uint32_t slot_count;
+  uint32_t live;
+  uint64_t used[SLAB_SIZE / 16 / 64];
+};
+
+struct Free_Slot {
+  Free_Slot *next;
+};
+
+static const size_t slab_data_offset = (sizeof(Slab) + 63) & ~(size_t)63;
+
+static Slab *slabs[SLAB_CLASSES] = {};
+static Free_Slot *free_lists[SLAB_CLASSES] = {};
+
+// sorted, for validating addresses found while scanning the stack
+static std::vector<Slab *> slab_index;
+
+static uint8_t size_to_class[SLAB_MAX_SLOT / 16 + 1];
+static bool classes_ready = false;
+
+static void init_classes() {
+  int cls = 0;
+  for (size_t i = 0; i <= SLAB_MAX_SLOT / 16; i++) {
+    while (class_sizes[cls] < i * 16) {
+      cls++;
+    }
+    size_to_class[i] = cls;
+  }
+  classes_ready = true;
+}
+
+static char *slot_at(Slab *slab, uint32_t index) {
+  return (char *)slab + slab_data_offset + (size_t)index * slab->slot_size;
+}
+
+static Slab *new_slab(int cls) {
+  Slab *slab = (Slab *)aligned_alloc(SLAB_SIZE, SLAB_SIZE);
+  if (slab == nullptr) {
+    fprintf(stderr, "Error: out of memory\n");
+    exit(1);
+  }
+  slab->size_class = cls;
+  slab->slot_size = class_sizes[cls];
+  slab->slot_count = (SLAB_SIZE - slab_data_offset) / slab->slot_size;
+  slab->live = 0;
+  std::fill(std::begin(slab->used), std::end(slab->used), 0);
+
+  slab->next = slabs[cls];
+  slabs[cls] = slab;
+  slab_index.insert(std::upper_bound(slab_index.begin(), slab_index.end(), slab), slab);
+  slab_stats.slabs++;
+
+  // thread the slots onto the free list back to front so they pop in address order
+  for (uint32_t i = slab->slot_count; i > 0; i--) {
+    Free_Slot *f = (Free_Slot *)slot_at(slab, i - 1);
+    f->next = free_lists[cls];
+    free_lists[cls] = f;
+  }
+  return slab;
+}
+
+static Slab *slab_of(uintptr_t addr) {
+  return (Slab *)(addr & ~(uintptr_t)(SLAB_SIZE - 1));
+}
+
+void *slab_alloc(size_t size) {
+  if (size > SLAB_MAX_SLOT) {
+    return nullptr;
+  }
+  if (!classes_ready) {
+    init_classes();
+  }
+  int cls = size_to_class[(size + 15) / 16];
+  if (free_lists[cls] == nullptr) {
+    new_slab(cls);
+  }
+  Free_Slot *f = free_lists[cls];
+  free_lists[cls] = f->next;
+
+  Slab *slab = slab_of((uintptr_t)f);
+  uint32_t index = ((char *)f - slot_at(slab, 0)) / slab->slot_size;
+  slab->used[index / 64] |= (uint64_t)1 << (index % 64);
+  slab->live++;
+  return f;
+}
+
+void *slab_find(uintptr_t addr) {
+  Slab *slab = slab_of(addr);
+  if (!std::binary_search(slab_index.begin(), slab_index.end(), slab)) {
+    return nullptr;
+  }
+  uintptr_t data = (uintptr_t)slot_at(slab, 0);
+  if (addr < data) {
+    return nullptr;
+  }
+  uint32_t index = (addr - data) / slab->slot_size;
+  if (index >= slab->slot_count) {
+    return nullptr;
+  }
+  if (!(slab->used[index / 64] & ((uint64_t)1 << (index % 64)))) {
+    return nullptr;
+  }
+  return slot_at(slab, index);
+}
+
+uint64_t slab_sweep(bool (*keep)(void *slot)) {
+  uint64_t freed = 0;
+  for (int cls = 0; cls < SLAB_CLASSES; cls++) {
+    free_lists[cls] = nullptr;
+    Free_Slot **tail = &free_lists[cls];
+    Slab **link = &slabs[cls];
+    bool kept_spare = false;
+
+    while (*link != nullptr) {
+      Slab *slab = *link;
+      Free_Slot **slab_start = tail;
+
+      for (uint32_t i = 0; i < slab->slot_count; i++) {
+	uint64_t bit = (uint64_t)1 << (i % 64);
+	char *slot = slot_at(slab, i);
+	if (slab->used[i / 64] & bit) {
+	  if (keep(slot)) {
+	    continue;
+	  }
+	  slab->used[i / 64] &= ~bit;
+	  slab->live--;
+	  freed++;
+	}
+	Free_Slot *f = (Free_Slot *)slot;
+	*tail = f;
+	tail = &f->next;
+      }
+      *tail = nullptr;
+
+      if (slab->live == 0 && kept_spare) {
+	// drop its slots from the free list again and hand the memory back
+	tail = slab_start;
+	*tail = nullptr;
+	*link = slab->next;
+	slab_index.erase(std::lower_bound(slab_index.begin(), slab_index.end(), slab));
+	free(slab);
+	slab_stats.slabs--;
+	slab_stats.slabs_released++;
+      } else {
+	// one empty slab per class is kept so a steady state loop doesn't
+	// allocate and release a slab on every collection
+	kept_spare |= (slab->live == 0);
+	link = &slab->next;
+      }
+    }
+  }
+  return freed;
+}
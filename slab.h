@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Size segregated slab allocator backing the collected heap.
+//
+// Slabs are SLAB_SIZE aligned blocks carved into equal sized slots, every slab
+// serves exactly one size class. Each class has its own free list threaded
+// through the free slots, so allocation is a pop and the slots of a class
+// stay packed together in memory. Because slabs are aligned, the slab of any
+// address is found by masking, which is what conservative stack scanning needs.
+
+const size_t SLAB_SIZE = 256 * 1024;
+const size_t SLAB_MAX_SLOT = 512;
+
+struct Slab_Stats {
+  uint64_t slabs = 0;
+  uint64_t slabs_released = 0;
+};
+
+extern Slab_Stats slab_stats;
+
+// returns nullptr if size is bigger than SLAB_MAX_SLOT
+void *slab_alloc(size_t size);
+
+// returns the start of the allocated slot containing addr, or nullptr
+void *slab_find(uintptr_t addr);
+
+// Visits every allocated slot, keep decides whether it survives. Freed slots
+// go back on the free lists, which are rebuilt in address order, and slabs
+// left completely empty are released in bulk. Returns the number freed.
+uint64_t slab_sweep(bool (*keep)(void *slot));
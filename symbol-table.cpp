@@ -1,34 +1,143 @@
 #include "parser.h"
 #include "interp_exceptions.h"
 
-void Symbol_Table::insert(std::string symbol, Parse_Node *node) {
-  table.insert(std::pair<std::string, Parse_Node *>(symbol, node));  
+uint32_t definition_epoch = 1;
+
+static bool is_function(Parse_Node *node) {
+  return node != nullptr && node_type(node) == PARSE_NODE_FUNCTION;
+}
+
+// fibonacci hashing, ids are handed out sequentially so spread them out
+static inline uint32_t hash_id(uint32_t id, uint32_t capacity) {
+  return (uint32_t)((id * 2654435769u) >> 7) & (capacity - 1);
+}
+
+// Global table only. Returns the entry holding id, or the empty entry
+// where it would go.
+Symbol_Table::Entry *Symbol_Table::slot(uint32_t id) {
+  uint32_t mask = capacity - 1;
+  uint32_t i = hash_id(id, capacity);
+  while (entries[i].id != id && entries[i].id != EMPTY) {
+    i = (i + 1) & mask;
+  }
+  return &entries[i];
+}
+
+// nullptr if id isn't bound in this table
+Symbol_Table::Entry *Symbol_Table::find_entry(uint32_t id) {
+  if (is_frame()) {
+    for (uint32_t i = 0; i < count; i++) {
+      if (entries[i].id == id) {
+	return &entries[i];
+      }
+    }
+    return nullptr;
+  }
+  Entry *e = slot(id);
+  return (e->id == EMPTY) ? nullptr : e;
+}
+
+void Symbol_Table::grow() {
+  Entry *old = entries;
+  uint32_t old_capacity = capacity;
+
+  capacity *= 2;
+  entries = new Entry[capacity];
+  for (uint32_t i = 0; i < capacity; i++) {
+    entries[i].id = EMPTY;
+  }
+  for (uint32_t i = 0; i < old_capacity; i++) {
+    if (old[i].id == EMPTY) {
+      continue;
+    }
+    if (is_frame()) {
+      entries[i] = old[i];
+    } else {
+      *slot(old[i].id) = old[i];
+    }
+  }
+  if (old != inline_entries) {
+    delete[] old;
+  }
 }
 
-Parse_Node *Symbol_Table::lookup(std::string symbol) {
-  std::map<std::string, Parse_Node *>::iterator it;
-  
-  it = table.find(symbol);
-  if (it != table.end()) {
-    return it->second;
-  } else if (parent_table != nullptr) {
-    return parent_table->lookup(symbol);
-  } else {
-    throw runtimeError("Error: unbound symbol: " + symbol + "\n");
+void Symbol_Table::insert(uint32_t id, Parse_Node *node) {
+  if (find_entry(id) == nullptr) {
+    define(id, node);
   }
 }
 
-Parse_Node *Symbol_Table::set(std::string symbol, Parse_Node *node) {
-  std::map<std::string, Parse_Node *>::iterator it;
+void Symbol_Table::define(uint32_t id, Parse_Node *node) {
+  Entry *e = find_entry(id);
+  if (e == nullptr) {
+    if (is_frame()) {
+      if (count == capacity) {
+	grow();
+      }
+      e = &entries[count];
+    } else {
+      // keep the load factor at or under 3/4
+      if ((count + 1) * 4 > capacity * 3) {
+	grow();
+      }
+      e = slot(id);
+    }
+    e->id = id;
+    count++;
+  }
+  e->value = node;
+}
+
+Parse_Node *Symbol_Table::find(uint32_t id) {
+  Entry *e = find_entry(id);
+  return (e == nullptr) ? nullptr : e->value;
+}
+
+Parse_Node *Symbol_Table::bound_value(uint32_t id) {
+  for (Symbol_Table *env = this; env != nullptr; env = env->parent_table) {
+    Entry *e = env->find_entry(id);
+    if (e != nullptr) {
+      return e->value;
+    }
+  }
+  return nullptr;
+}
+
+Parse_Node *Symbol_Table::lookup(uint32_t id) {
+  for (Symbol_Table *env = this; env != nullptr; env = env->parent_table) {
+    Entry *e = env->find_entry(id);
+    if (e != nullptr) {
+      return e->value;
+    }
+  }
+  throw runtimeError("Error: unbound symbol: " + interned_name(id) + "\n");
+}
+
+Parse_Node *Symbol_Table::bound_value(uint32_t id, uint64_t address) {
+  uint32_t depth = address >> 32;
+  uint32_t index = (uint32_t)address;
+
+  Symbol_Table *env = this;
+  for (uint32_t i = 0; i < depth && env != nullptr; i++) {
+    env = env->parent_table;
+  }
+  if (env != nullptr && env->is_frame() && index < env->count && env->entries[index].id == id) {
+    return env->entries[index].value;
+  }
+  return bound_value(id);
+}
 
-  it = table.find(symbol);
-  if (it != table.end()) {
-    table[symbol] = node;
-    return node;
-  } else if (parent_table != nullptr) {
-    return parent_table->set(symbol, node);
-  } else {
-    fprintf(stderr, "Error: unbound symbol: `%s`\n", symbol.c_str());
-    return nullptr;    
+Parse_Node *Symbol_Table::set(uint32_t id, Parse_Node *node) {
+  for (Symbol_Table *env = this; env != nullptr; env = env->parent_table) {
+    Entry *e = env->find_entry(id);
+    if (e != nullptr) {
+      if (!env->is_frame() && (is_function(e->value) || is_function(node))) {
+	definition_epoch++;
+      }
+      e->value = node;
+      return node;
+    }
   }
+  fprintf(stderr, "Error: unbound symbol: `%s`\n", interned_name(id).c_str());
+  return nullptr;
 }
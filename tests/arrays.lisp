@@ -0,0 +1,50 @@
+; packed arrays: reductions, elementwise kernels, shifts, element access and errors
+(defsym a (int-array 1 2 3 4 5 6 7 8 9))
+(print a)
+(print (type-of a))
+(print (array-sum a))
+(print (array-min a) (array-max a))
+(print (array-dot a a))
+(print (array-scale a 3))
+(print (array-add a a))
+(print (array-mul a a))
+(print (array-and a (make-int-array 9 6)))
+(print (array-or a (make-int-array 9 16)))
+(print (array-xor a (make-int-array 9 1)))
+(print (array-shl a) (array-shl a 4))
+(print (array-shr (array-scale a (- 0 100)) 3))
+(defsym f (float-array 1.5 2 3.25))
+(print f (type-of f))
+(print (array-sum f) (array-min f) (array-max f) (array-dot f f))
+(print (array-scale f 2) (array-add f f) (array-mul f f))
+(print (length a) (first a) (last a) (nth 3 a) (empty? (make-int-array 0)))
+(set (nth 2 a) 100)
+(set (first f) 7)
+(print a f)
+(defsym c (copy a))
+(set (last c) 0)
+(print a c)
+(for-each (x f) (print x))
+(defsym big (make-int-array 1000 9223372036854775807))
+(print (array-sum big))
+(print (array-sum (int-array 9223372036854775807 1 (- 0 1))))
+(print (array-add (int-array 9223372036854775807) (int-array 1)))
+(print (array-min (make-float-array 0)))
+(print (array-add a f))
+(print (array-add a (int-array 1)))
+(print (array-and f f))
+(print (array-shl a 64))
+(print (nth 20 a))
+(set (nth 1 a) 1.5)
+(print (int-array 1 "x"))
+(defsym m (make-int-array 37 0))
+(for-each (i (int-array 0 5 10 36)) (set (nth (+ i 1) m) (- 0 i)))
+(print (array-min m) (array-max m) (array-sum m))
+(defsym g (make-float-array 37 1))
+(set (nth 30 g) (- 0 2.5))
+(print (array-min g) (array-max g) (array-sum g) (array-dot g g))
+; shift counts are 0 to 63
+(print (array-shl (int-array 1) 63) (array-shr (int-array (- 0 8)) 63))
+(print (array-shr a 64))
+(print (array-shl a (- 0 1)))
+(print (array-shl a 1.5))
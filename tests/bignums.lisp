@@ -0,0 +1,52 @@
+; bignums: promotion on overflow, sign and carry, demotion, comparisons, long literals
+(defsym big 123456789012345678901234567890)
+(print big (type-of big))
+(print (+ 9223372036854775807 1))
+(print (- 0 9223372036854775807 2))
+(print (* 4611686018427387904 2) (* 4611686018427387904 (- 0 2)))
+(print (- big big) (type-of (- big big)))
+(print (- (+ big 1) big))
+(print (* big big))
+(print (* big 0) (* big 1.5))
+(print (+ big 0.5))
+(print (< 1 big) (> 1 big) (= big 123456789012345678901234567890) (= big (+ big 1)))
+(print (< (- 0 big) 0 big) (>= big 1.5))
+(defun fact (n) (if (< n 2) 1 (* n (fact (- n 1)))))
+(print (fact 30))
+(print (fact 100))
+(defun fib (n) (let ((a 0) (b 1) (i 0)) (while (< i n) (let ((t (+ a b))) (set a b) (set b t)) (set i (+ i 1))) a))
+(print (fib 300))
+(defun pow (b e) (let ((r 1) (i 0)) (while (< i e) (set r (* r b)) (set i (+ i 1))) r))
+(defsym p (pow 3 3000))
+(defsym q (pow 7 2000))
+(print (= (* p q) (* q p)))
+(print (= (- (* (+ p 1) (+ p 1)) (* p p) (* 2 p)) 1))
+(print (= (* (pow 2 4000) (pow 2 4000)) (pow 2 8000)))
+(defsym s 1000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000001)
+(print (= s (+ (pow 10 1500) 1)))
+(defsym h (make-hash))
+(hash-set h big 1)
+(hash-set h (+ big 1) 2)
+(print (hash-get h 123456789012345678901234567890) (hash-get h (- (+ big 2) 1)) (hash-count h))
+(print (type= 1 big) (type= big 1.5))
+(print (array-sum (int-array 9223372036854775807 9223372036854775807 1)))
+(print (array-dot (int-array 4611686018427387904 3) (int-array 4 5)))
+(print (copy big))
+(print (int-array big))
+(print 9223372036854775807 9223372036854775808 0000000000000000000000000042)
+; carries and borrows across limbs
+(defsym two64 (* 4294967296 4294967296))
+(print two64 (- two64 1) (+ (- two64 1) 1))
+(print (- (* two64 two64) 1) (+ (- (* two64 two64) 1) 1))
+(print (- (* two64 two64) two64))
+; signs, results crossing zero and products of negatives
+(defsym neg (- 0 big))
+(print neg (+ neg 1) (+ neg big) (- neg big) (+ big (- 0 big 1)))
+(print (* neg neg) (* neg big) (* neg (- 0 1)))
+(print (< neg (- 0 1)) (> neg (- 0 big 1)) (= (- 0 neg) big))
+; back to 64 bits at both ends of the range
+(defsym min64 (- 0 9223372036854775807 1))
+(print min64 (type-of min64))
+(print (- min64 1) (type-of (- min64 1)) (+ (- min64 1) 1) (type-of (+ (- min64 1) 1)))
+(print (- (+ 9223372036854775807 1) 1) (type-of (- (+ 9223372036854775807 1) 1)))
+(print (* min64 (- 0 1)) (* min64 min64))
@@ -0,0 +1,14 @@
+; bad arguments to the bitwise operators are errors like anywhere else and
+; never stop the program
+(print (+ 1 (<< 1 'a)))
+(print (+ 1 (>> 'a 1)))
+(print (& 12 'b))
+(print (| 1 100000000000000000000000))
+(print (list (& 12 10) (| 12 10) (^ 12 10) (<< 1 4) (>> 16) (<< 3)))
+; shift counts are 0 to 63, and a left shift can't push bits out
+(print (<< 1 64))
+(print (<< 1 (- 0 1)))
+(print (>> 8 64))
+(print (<< 3 62))
+(print (<< 1 63))
+(print (list (<< 1 62) (<< (- 0 1) 63) (>> (- 0 8) 1) (<< 1 0) (>> 5 0)))
@@ -0,0 +1,11 @@
+; a cached call site must still see a local that shadows its operator
+(defun sq (x) (* x x))
+(defun f (x) x)
+(defsym code '(f 3))
+(print (eval code))
+(print (let ((f sq)) (eval code)))
+(print (eval code))
+(defun g (x) (+ (f x) 1))
+(print (g 4))
+(defun f (x) (* x 10))
+(print (g 4))
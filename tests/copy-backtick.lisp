@@ -0,0 +1,8 @@
+; a copy of a backtick that has already been evaluated
+(defsym q '(1 2 3))
+(defsym form '`(+ ,@q 4))
+(print (eval form))
+(print (eval (eval form)))
+(defsym form2 (copy form))
+(print (eval form2))
+(print (eval (eval form2)))
@@ -0,0 +1,19 @@
+; a copied function keeps working once the original is collected, its
+; parameter list is built at run time so nothing else holds on to it
+(eval (list 'defun 'f (list 'a '&optional (list 'b 2)) (list '+ 'a 'b)))
+(defsym g (copy f))
+(defun f (x) x)
+(progn (gc) 0)
+(print (g 1))
+(print (g 1 5))
+(print (f 1))
+; copying a function that has already been compiled
+(defun h (x) (* x 3))
+(print (h 2))
+(defsym h2 (copy h))
+(print (h2 4))
+(defmacro twice (x) (list '+ x x))
+(defun k (x) (twice x))
+(print (k 5))
+(defsym k2 (copy k))
+(print (k2 6))
@@ -0,0 +1,12 @@
+; forms nested deeper than the stack allows stop with an error in every
+; engine, whether they are evaluated, translated or compiled
+(defun nestp (n)
+  (let ((form 0) (i 0))
+    (while (< i n)
+      (set form (list '+ 1 form))
+      (set i (+ i 1)))
+    form))
+(eval (nestp 100000))
+(eval (list 'defun 'deep '() (nestp 100000)))
+(deep)
+(print (eval (nestp 1000)))
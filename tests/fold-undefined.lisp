@@ -0,0 +1,6 @@
+; arguments of a call to an operator that isn't defined yet aren't folded,
+; it may be a macro that uses them as they are written
+(defun g () (mymac (+ 1 2)))
+(defmacro mymac (x) (list 'quote x))
+(print (g))
+(print (mymac (* 2 3)))
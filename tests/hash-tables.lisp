@@ -0,0 +1,85 @@
+; hash tables: key kinds, removal, growth, iteration, copies and errors
+(defsym h (make-hash))
+(print h (type-of h))
+(hash-set h 1 "one")
+(hash-set h "two" 2)
+(hash-set h 'three 3)
+(hash-set h :four 4)
+(hash-set h 4611686018427387904 "big")
+(print (hash-get h 1) (hash-get h "two") (hash-get h 'three) (hash-get h :four) (hash-get h 4611686018427387904))
+(print (hash-get h 5) (hash-get h 5 'none) (hash-get h 'four) (hash-count h))
+(defsym k "key")
+(hash-set h k 10)
+(set (first k) "x")
+(print k (hash-get h "key") (hash-get h "xey"))
+(hash-set h 1 "uno")
+(print (hash-get h 1) (hash-count h))
+(print (hash-remove h 1) (hash-remove h 1) (hash-get h 1) (hash-count h))
+(defun fill (h n)
+  (let ((i 0))
+    (while (< i n)
+      (hash-set h i (* i i))
+      (set i (+ i 1)))
+    h))
+(defun check (h n)
+  (let ((i 0) (ok true))
+    (while (< i n)
+      (unless (= (hash-get h i) (* i i)) (set ok false))
+      (set i (+ i 1)))
+    ok))
+(defun drop-odd (h n)
+  (let ((i 1))
+    (while (< i n)
+      (hash-remove h i)
+      (set i (+ i 2)))
+    h))
+(defsym big (fill (make-hash) 5000))
+(print (hash-count big) (check big 5000))
+(drop-odd big 5000)
+(print (hash-count big) (hash-get big 7) (hash-get big 8))
+(fill big 5000)
+(print (hash-count big) (check big 5000))
+(defun total (h)
+  (let ((s 0))
+    (hash-for-each (k v h) (set s (+ s v)))
+    s))
+(print (total big))
+(defsym small (make-hash))
+(hash-set small 'a 1)
+(hash-set small 'b 2)
+(hash-for-each (k v small) (hash-remove small 'a) (hash-remove small 'b) (hash-set small k (* v 10)))
+(print (hash-count small) (hash-get small 'a) (hash-get small 'b))
+(defsym c (copy small))
+(hash-set c 'a 0)
+(print (hash-get small 'a) (hash-get c 'a))
+(defsym strs (make-hash))
+(for-each (s '("a" "b" "c" "a")) (hash-set strs s (+ 1 (hash-get strs s 0))))
+(print (hash-get strs "a") (hash-get strs "c") (hash-count strs))
+(hash-set h 1.5 1)
+(hash-set h '(1) 1)
+(hash-get 3 1)
+(hash-for-each (k h) k)
+(print (eval h))
+; the 57th key grows a 64 slot table, the old slots move over a few at a
+; time, so everything below runs while the old array is still being
+; emptied
+(defsym r (fill (make-hash) 56))
+(hash-set r 56 (* 56 56))
+(print (hash-count r) (check r 57))
+(print (hash-get r 3) (hash-remove r 3) (hash-get r 3) (hash-remove r 3))
+(hash-set r 5 'five)
+(print (hash-get r 5) (hash-count r))
+(defsym r2 (copy r))
+(hash-set r2 5 'cinq)
+(print (hash-get r 5) (hash-get r2 5) (hash-count r2))
+(let ((n 0))
+  (hash-for-each (k v r) (set n (+ n 1)))
+  (print n))
+(hash-set r 3 9)
+(hash-set r 5 25)
+(print (check r 57))
+; and growing again right after, through several more resizes
+(fill r 1000)
+(print (hash-count r) (check r 1000))
+(drop-odd r 1000)
+(print (hash-count r) (hash-get r 999) (hash-get r 998))
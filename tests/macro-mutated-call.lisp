@@ -0,0 +1,10 @@
+; a call form changed in place is expanded again
+(defmacro second-of (a b) b)
+(defsym form '(second-of 0 1))
+(print (eval form))
+(set (nth 3 form) 2)
+(print (eval form))
+(defsym built (list 'second-of 0 1))
+(print (eval built))
+(set (nth 3 built) 3)
+(print (eval built))
@@ -0,0 +1,19 @@
+; a function using a macro sees the macro's new definition
+(defmacro m () 1)
+(defun usem () (m))
+(print (usem))
+(defmacro m () 2)
+(print (usem))
+; and a macro the expansion calls being redefined
+(defmacro inner () 10)
+(defmacro outer () '(+ (inner) 1))
+(defun useo () (outer))
+(print (useo))
+(defmacro inner () 20)
+(print (useo))
+; a tail call in an expansion is still a tail call after the redefinition
+(defun down (n) (if (< n 1) 0 (next n)))
+(defmacro next (n) (list 'down (list '- n 1)))
+(print (down 10000))
+(defmacro next (n) (list 'down (list '- n 2)))
+(print (down 10000))
@@ -0,0 +1,18 @@
+#!/bin/sh
+# Runs every tests/*.lisp under each engine and compares the output, colors
+# stripped, with the .out file next to it. Run from the top of the tree:
+#   make test
+status=0
+for test in tests/*.lisp; do
+  expected="${test%.lisp}.out"
+  for engine in closure tree vm; do
+    ./pl --engine=$engine "$test" 2>&1 | sed 's/\x1b\[[0-9]*m//g' > /tmp/pl-test.out
+    if ! diff -u "$expected" /tmp/pl-test.out > /tmp/pl-test.diff; then
+      echo "FAIL $test ($engine)"
+      head -20 /tmp/pl-test.diff
+      status=1
+    fi
+  done
+done
+[ $status = 0 ] && echo "all tests passed"
+exit $status
@@ -0,0 +1,54 @@
+; vectors: indexing, append while iterating, splices, copies and errors
+(defsym v [1 2 (+ 1 2)])
+(print v)
+(print (type-of v))
+(print (length v) (first v) (last v) (nth 2 v))
+(append 4 v)
+(print v (length v))
+(set (nth 1 v) 10)
+(set (first v) 11)
+(set (last v) 44)
+(print v)
+(print (push 0 v) v)
+(defsym e [])
+(print e (empty? e) (empty? v) (first e) (last e) (length e))
+(print (vector 1 "a" 'b) (make-vector 3 0) (make-vector 2))
+(let ((x 5) (l '(7 8)))
+  (print [x ,@l ,@[9 10] (* x x)]))
+(defun vsum (vec)
+  (let ((s 0))
+    (for-each (x vec) (set s (+ s x)))
+    s))
+(print (vsum v))
+(defsym grow [1])
+(for-each (x grow) (when (< x 5) (append (+ x 1) grow)))
+(print grow)
+(defsym q '[a b])
+(print q)
+(defsym c (copy [[1 2] '(3 4)]))
+(print c)
+(set (first (first c)) 100)
+(print c)
+(print (type= [1] [2]))
+(defun fill (n)
+  (let ((vec (make-vector n 0)) (i 1))
+    (while (<= i n)
+      (set (nth i vec) (* i i))
+      (set i (+ i 1)))
+    vec))
+(print (fill 10))
+(nth 0 v)
+(nth 9 v)
+(set (first e) 1)
+(make-vector (- 0 1))
+[1 ,@3]
+(print [[1 [2 [3]]] "s"])
+; appending well past the initial capacity keeps every element
+(defun count-up (n)
+  (let ((vec []) (i 0))
+    (while (< i n)
+      (append i vec)
+      (set i (+ i 1)))
+    vec))
+(defsym many (count-up 1000))
+(print (length many) (first many) (nth 500 many) (last many) (vsum many))
@@ -0,0 +1,791 @@
+#include <unordered_map>
+#include "vm.h"
+#include "interp.h"
+#include "builtin_helpers.h"
+#include "builtin_logic.h"
+#include "builtin_math.h"
+
+enum Op : uint32_t {
+  OP_CONST,         // k              push constants[k]
+  OP_NIL,           //                push a new empty list
+  OP_NAME,          // id             push the value of id, looked up by name
+  OP_LOCAL,         // id hi lo       push the value of id at lexical address hi:lo
+  OP_SET,           // id             pop a value and set id to it
+  OP_DEFINE,        // id             pop a value and bind id in the current frame
+  OP_PUSH_FRAME,    //                enter a new frame
+  OP_POP_FRAME,     //                leave the current frame
+  OP_POP,
+  OP_JUMP,          // target
+  OP_JUMP_IF_FALSE, // target         pop, jump unless truthy
+  OP_LOOP_TEST,     // target         pop, jump unless true, a non boolean is an error
+  OP_EVAL,          // k              push the tree-walker's value of constants[k]
+  OP_PREPARE,       // id k e skip    push the callee, or eval constants[k] and skip the call
+  OP_MACRO,         // id m e k skip  run on into the expansion if id is still constants[m] and
+                    //                the macro epoch is e, else eval constants[k] and skip it
+  OP_CALL,          // argc           pop callee and args, push the result
+  OP_TAIL_CALL,     // argc           same, by running the callee's chunk in place of this one
+  OP_ADD,           // two argument calls with a fixnum fast path
+  OP_SUB,
+  OP_LT,
+  OP_LE,
+  OP_GT,
+  OP_GE,
+  OP_EQ,
+  OP_RETURN,
+  OP_COUNT,
+};
+
+// A call from one chunk to another doesn't recurse into vm_run, the caller
+// is suspended on vm_frames and its environment kept on vm_frame_envs.
+struct Frame {
+  Chunk *chunk;
+  const uint32_t *pc;
+  size_t base;  // where the callee sits on vm_stack, the result replaces it
+};
+
+static std::vector<Parse_Node *> vm_stack;
+static std::vector<Frame> vm_frames;
+static std::vector<Symbol_Table *> vm_frame_envs;
+static std::unordered_map<Parse_Node *, Chunk *> function_chunks;
+
+void vm_init() {
+  engine = ENGINE_VM;
+  gc_add_root(&vm_stack);
+  gc_add_root(&vm_frame_envs);
+}
+
+// everything a run pushed is dropped when it returns or unwinds
+struct Stack_Mark {
+  size_t base;
+  Stack_Mark() { base = vm_stack.size(); }
+  ~Stack_Mark() { vm_stack.resize(base); }
+};
+
+// frames a run suspended, dropped if it unwinds
+struct Frames_Mark {
+  size_t base;
+  Frames_Mark() { base = vm_frames.size(); }
+  ~Frames_Mark() {
+    call_depth -= vm_frames.size() - base;
+    vm_frames.resize(base);
+    vm_frame_envs.resize(base);
+  }
+};
+
+//
+// compiler
+//
+
+struct Compiler {
+  Chunk *chunk;
+  Symbol_Table *env;  // operators are looked up here at compile time
+
+  void emit(uint32_t word) { chunk->code.push_back(word); }
+  uint32_t constant(Parse_Node *node);
+  uint32_t emit_jump(Op op);
+  void patch(uint32_t at) { chunk->code[at] = chunk->code.size(); }
+
+  // tail is set for forms whose value is the value of the function
+  void compile(Parse_Node *node, bool tail = false);
+  void compile_body(Parse_Node *forms, bool tail = false);
+  void compile_eval(Parse_Node *node);
+  bool compile_call(Parse_Node *node, bool tail);
+  bool compile_macro(Parse_Node *macro, Parse_Node *node, bool tail);
+  bool compile_special(Parse_Node *(*builtin)(Parse_Node *, Symbol_Table *), Parse_Node *args, bool tail);
+  bool compile_let(Parse_Node *args, bool tail);
+};
+
+uint32_t Compiler::constant(Parse_Node *node) {
+  chunk->constants.push_back(node);
+  return chunk->constants.size() - 1;
+}
+
+uint32_t Compiler::emit_jump(Op op) {
+  emit(op);
+  emit(0);
+  return chunk->code.size() - 1;
+}
+
+void Compiler::compile_eval(Parse_Node *node) {
+  emit(OP_EVAL);
+  emit(constant(node));
+}
+
+// forms is a non empty list, the value of the last form is left
+void Compiler::compile_body(Parse_Node *forms, bool tail) {
+  while (!is_empty_list(forms)) {
+    compile(forms->first, tail && is_empty_list(forms->next));
+    if (!is_empty_list(forms->next)) {
+      emit(OP_POP);
+    }
+    forms = forms->next;
+  }
+}
+
+void Compiler::compile(Parse_Node *node, bool tail) {
+  check_call_depth();
+  switch (node_type(node)) {
+  case PARSE_NODE_LITERAL: {
+    emit(OP_CONST);
+    emit(constant(node));
+    return;
+  }
+  case PARSE_NODE_SYMBOL: {
+    if (is_keyword(node)) {
+      emit(OP_CONST);
+      emit(constant(node));
+    } else if (node->flags & NODE_LEXICAL_ADDRESS) {
+      emit(OP_LOCAL);
+      emit(node->aux);
+      emit(node->val.u64 >> 32);
+      emit((uint32_t)node->val.u64);
+    } else {
+      emit(OP_NAME);
+      emit(node->aux);
+    }
+    return;
+  }
+  case PARSE_NODE_SYNTAX: {
+    if (node->subtype == SYNTAX_QUOTE) {
+      emit(OP_CONST);
+      emit(constant(node->first));
+    } else {
+      compile_eval(node);
+    }
+    return;
+  }
+  case PARSE_NODE_LIST: {
+    if (is_empty_list(node)) {
+      emit(OP_CONST);
+      emit(constant(node));
+    } else if (!compile_call(node, tail)) {
+      compile_eval(node);
+    }
+    return;
+  }
+  default:
+    compile_eval(node);
+    return;
+  }
+}
+
+bool Compiler::compile_macro(Parse_Node *macro, Parse_Node *node, bool tail) {
+  Parse_Node *expansion;
+  try {
+    expansion = expand_macro(macro, node, env);
+  } catch (runtimeError &e) {
+    // let the tree-walker report it when the form is run
+    return false;
+  }
+  // the expansion is only good while the macro it came from is
+  chunk->expands_macros = true;
+  chunk->macro_epoch = current_macro_epoch();
+  emit(OP_MACRO);
+  emit(node->first->aux);
+  emit(constant(macro));
+  emit(current_macro_epoch());
+  emit(constant(node));
+  emit(0);
+  uint32_t skip = chunk->code.size() - 1;
+  constant(expansion);
+  compile(expansion, tail);
+  patch(skip);
+  return true;
+}
+
+bool Compiler::compile_let(Parse_Node *args, bool tail) {
+  if (is_empty_list(args) || !is_list(args->first)) {
+    return false;
+  }
+  for (Parse_Node *defs = args->first; !is_empty_list(defs); defs = defs->next) {
+    Parse_Node *let_form = defs->first;
+    if (is_list(let_form)) {
+      int lfs = let_form->length();
+      if ((lfs != 1 && lfs != 2) || !is_sym(let_form->first)) {
+	return false;
+      }
+    } else if (!is_sym(let_form)) {
+      return false;
+    }
+  }
+
+  emit(OP_PUSH_FRAME);
+  for (Parse_Node *defs = args->first; !is_empty_list(defs); defs = defs->next) {
+    Parse_Node *let_form = defs->first;
+    Parse_Node *sym = let_form;
+    if (is_list(let_form)) {
+      sym = let_form->first;
+      if (is_empty_list(let_form->next)) {
+	emit(OP_NIL);
+      } else {
+	compile(let_form->next->first);
+      }
+    } else {
+      emit(OP_NIL);
+    }
+    emit(OP_DEFINE);
+    emit(sym->aux);
+  }
+  if (is_empty_list(args->next)) {
+    emit(OP_NIL);
+  } else {
+    compile_body(args->next, tail);
+  }
+  emit(OP_POP_FRAME);
+  return true;
+}
+
+// the builtins that don't evaluate their arguments like a function call
+bool Compiler::compile_special(Parse_Node *(*builtin)(Parse_Node *, Symbol_Table *), Parse_Node *args, bool tail) {
+  int argc = args->length();
+
+  if (builtin == builtin_quote && argc == 1) {
+    emit(OP_CONST);
+    emit(constant(args->first));
+    return true;
+  }
+
+  if (builtin == builtin_if && (argc == 2 || argc == 3)) {
+    compile(args->first);
+    uint32_t to_else = emit_jump(OP_JUMP_IF_FALSE);
+    compile(args->next->first, tail);
+    uint32_t to_end = emit_jump(OP_JUMP);
+    patch(to_else);
+    if (argc == 3) {
+      compile(args->next->next->first, tail);
+    } else {
+      emit(OP_NIL);
+    }
+    patch(to_end);
+    return true;
+  }
+
+  if (builtin == builtin_while && argc >= 2) {
+    // the value of the last body form, or () if the body never ran
+    emit(OP_NIL);
+    uint32_t loop = chunk->code.size();
+    compile(args->first);
+    uint32_t to_end = emit_jump(OP_LOOP_TEST);
+    emit(OP_POP);
+    compile_body(args->next);
+    emit(OP_JUMP);
+    emit(loop);
+    patch(to_end);
+    return true;
+  }
+
+  if (builtin == builtin_progn && argc >= 1) {
+    compile_body(args, tail);
+    return true;
+  }
+
+  if (builtin == builtin_set && argc == 2 && is_sym(args->first)) {
+    compile(args->next->first);
+    emit(OP_SET);
+    emit(args->first->aux);
+    emit(OP_CONST);
+    emit(constant(args->first));
+    return true;
+  }
+
+  if (builtin == builtin_return && argc == 1) {
+    compile(args->first);
+    emit(OP_RETURN);
+    return true;
+  }
+
+  if (builtin == builtin_let) {
+    return compile_let(args, tail);
+  }
+  return false;
+}
+
+static Op two_argument_op(Values_Func builtin) {
+  if (builtin == builtin_add) return OP_ADD;
+  if (builtin == builtin_subtract) return OP_SUB;
+  if (builtin == builtin_less_than) return OP_LT;
+  if (builtin == builtin_less_than_equal) return OP_LE;
+  if (builtin == builtin_greater_than) return OP_GT;
+  if (builtin == builtin_greater_than_equal) return OP_GE;
+  if (builtin == builtin_equal) return OP_EQ;
+  return OP_CALL;
+}
+
+// returns false if the call has to be left to the tree-walker
+bool Compiler::compile_call(Parse_Node *node, bool tail) {
+  Parse_Node *op = node->first;
+  if (!is_sym(op) || (op->flags & NODE_LEXICAL_ADDRESS) || has_splice(node)) {
+    return false;
+  }
+  Parse_Node *func = env->bound_value(op->aux);
+  if (func == nullptr || node_type(func) != PARSE_NODE_FUNCTION) {
+    return false;
+  }
+
+  Parse_Node *args = node->next;
+  uint32_t expect = 0;
+  switch (func->subtype) {
+  case FUNCTION_MACRO:
+    return compile_macro(func, node, tail);
+  case FUNCTION_NATIVE:
+    break;
+  case FUNCTION_BUILTIN:
+    if (compile_special(forms_func(func), args, tail)) {
+      return true;
+    }
+    if (!(func->flags & NODE_STRICT_BUILTIN)) {
+      return false;
+    }
+    expect = constant(func) + 1;
+    break;
+  default:
+    return false;
+  }
+
+  // the callee is checked again when the call runs, it may have been redefined
+  emit(OP_PREPARE);
+  emit(op->aux);
+  emit(constant(node));
+  emit(expect);
+  emit(0);
+  uint32_t skip = chunk->code.size() - 1;
+
+  uint32_t argc = 0;
+  for (Parse_Node *arg = args; !is_empty_list(arg); arg = arg->next) {
+    compile(arg->first);
+    argc++;
+  }
+  Op call = (expect != 0 && argc == 2) ? two_argument_op(values_func(func)) : OP_CALL;
+  if (call == OP_CALL && expect == 0 && tail) {
+    call = OP_TAIL_CALL;
+  }
+  emit(call);
+  if (call == OP_CALL || call == OP_TAIL_CALL) {
+    emit(argc);
+  }
+  patch(skip);
+  return true;
+}
+
+// nullptr if the lambda list uses &rest or &optional
+static Chunk *compile_function(Parse_Node *fun) {
+  const Lambda_List *params = lambda_list(fun);
+  if (!params->is_fixed()) {
+    return nullptr;
+  }
+  Chunk *chunk = new Chunk();
+  chunk->params = params->required;
+
+  Compiler compiler{chunk, fun->val.env};
+  if (is_empty_list(fun->next)) {
+    compiler.emit(OP_NIL);
+  } else {
+    compiler.compile_body(fun->next, true);
+  }
+  compiler.emit(OP_RETURN);
+  return chunk;
+}
+
+static Chunk *function_chunk(Parse_Node *fun) {
+  Chunk *stale = nullptr;
+  auto it = (fun->flags & NODE_HAS_CHUNK) ? function_chunks.find(fun) : function_chunks.end();
+  if (it != function_chunks.end()) {
+    Chunk *chunk = it->second;
+    if (chunk == nullptr || !chunk->expands_macros ||
+	chunk->macro_epoch == current_macro_epoch()) {
+      return chunk;
+    }
+    // a macro was defined since, compiled again so the expansions don't
+    // all fall back to the tree-walker
+    stale = chunk;
+  }
+  Chunk *chunk = compile_function(fun);
+  if (chunk != nullptr) {
+    chunk->stale = stale;
+  }
+  fun->flags |= NODE_HAS_CHUNK;
+  function_chunks[fun] = chunk;
+  return chunk;
+}
+
+void vm_forget_chunk(Parse_Node *fun) {
+  auto it = function_chunks.find(fun);
+  if (it != function_chunks.end()) {
+    delete it->second;
+    function_chunks.erase(it);
+  }
+}
+
+//
+// interpreter
+//
+
+static Parse_Node *vm_run(Chunk *chunk, Symbol_Table *env);
+
+static Parse_Node *quoted(Parse_Node *value) {
+  if (node_type(value) == PARSE_NODE_LITERAL || (is_sym(value) && is_keyword(value))) {
+    return value;
+  }
+  Parse_Node *q = new Parse_Node{PARSE_NODE_SYNTAX, SYNTAX_QUOTE};
+  q->first = value;
+  return q;
+}
+
+// builtins take unevaluated arguments, so the values are passed quoted
+static Parse_Node *quoted_list(size_t first, uint32_t argc) {
+  Parse_Node *list = new Parse_Node{PARSE_NODE_LIST};
+  Parse_Node *cur = list;
+  for (uint32_t i = 0; i < argc; i++) {
+    cur->first = quoted(vm_stack[first + i]);
+    cur->next = new Parse_Node{PARSE_NODE_LIST};
+    cur = cur->next;
+  }
+  return list;
+}
+
+// the arguments are vm_stack[first, first + argc)
+static Parse_Node *call_native(Parse_Node *fun, size_t first, uint32_t argc) {
+  Chunk *chunk = function_chunk(fun);
+  if (chunk == nullptr) {
+    Parse_Node *call = new Parse_Node{PARSE_NODE_LIST};
+    call->first = fun;
+    call->next = quoted_list(first, argc);
+    return apply_fun(fun, call, fun->val.env);
+  }
+
+  if (argc < chunk->params.size()) {
+    throw runtimeError("Error: Not enough arguments given to invocation of " +
+		       symbol_name(fun) + "\n");
+  }
+  if (argc > chunk->params.size()) {
+    throw runtimeError("Error: Too many arguments given to invocation of " +
+		       symbol_name(fun) + "\n");
+  }
+
+  Symbol_Table *frame = new Symbol_Table(fun->val.env);
+  for (uint32_t i = 0; i < argc; i++) {
+    frame->define(chunk->params[i], vm_stack[first + i]);
+  }
+  Call_Depth depth;
+  Parse_Node *ret = vm_run(chunk, frame);
+  return is_return(ret) ? take_return() : ret;
+}
+
+// replaces the callee and its argc arguments on top of the stack with the result
+static void call_from_stack(uint32_t argc, Symbol_Table *env) {
+  size_t first = vm_stack.size() - argc;
+  Parse_Node *callee = vm_stack[first - 1];
+  Parse_Node *ret;
+  try {
+    if (callee->subtype == FUNCTION_NATIVE) {
+      ret = call_native(callee, first, argc);
+    } else if (callee->flags & NODE_VALUE_BUILTIN) {
+      ret = call_values(callee, vm_stack.data() + first, argc);
+    } else {
+      ret = callee->val.func(quoted_list(first, argc), env);
+    }
+  } catch (runtimeError &e) {
+    ret = error_value(e.what());
+  }
+  vm_stack.resize(first - 1);
+  vm_stack.push_back(ret);
+}
+
+static Parse_Node *unbound(uint32_t id) {
+  return error_value("Error: unbound symbol: " + interned_name(id) + "\n");
+}
+
+static Parse_Node *vm_run(Chunk *chunk, Symbol_Table *env) {
+  static void *dispatch[] = {
+    &&op_const, &&op_nil, &&op_name, &&op_local, &&op_set, &&op_define,
+    &&op_push_frame, &&op_pop_frame, &&op_pop, &&op_jump, &&op_jump_if_false,
+    &&op_loop_test, &&op_eval, &&op_prepare, &&op_macro, &&op_call,
+    &&op_tail_call, &&op_add, &&op_sub, &&op_lt, &&op_le, &&op_gt, &&op_ge, &&op_eq,
+    &&op_return,
+  };
+  static_assert(sizeof(dispatch) / sizeof(dispatch[0]) == OP_COUNT, "dispatch table out of date");
+
+  Stack_Mark mark;
+  Frames_Mark frames;
+  const uint32_t *code = chunk->code.data();
+  Parse_Node **constants = chunk->constants.data();
+  const uint32_t *pc = code;
+  Parse_Node *a, *b;
+
+#define NEXT goto *dispatch[*pc++]
+#define FIXNUM_OPERANDS() (b = vm_stack.back(), a = vm_stack[vm_stack.size() - 2], \
+			   is_fixnum(a) && is_fixnum(b))
+#define REPLACE_CALL(value) do {					\
+    Parse_Node *result = (value);					\
+    vm_stack.resize(vm_stack.size() - 3);				\
+    vm_stack.push_back(result);						\
+  } while (0)
+
+  NEXT;
+
+ op_const:
+  vm_stack.push_back(constants[*pc++]);
+  NEXT;
+
+ op_nil:
+  vm_stack.push_back(new Parse_Node{PARSE_NODE_LIST});
+  NEXT;
+
+ op_name:
+  a = env->bound_value(pc[0]);
+  vm_stack.push_back((a != nullptr) ? a : unbound(pc[0]));
+  pc += 1;
+  NEXT;
+
+ op_local:
+  a = env->bound_value(pc[0], ((uint64_t)pc[1] << 32) | pc[2]);
+  vm_stack.push_back((a != nullptr) ? a : unbound(pc[0]));
+  pc += 3;
+  NEXT;
+
+ op_set:
+  env->set(*pc++, vm_stack.back());
+  vm_stack.pop_back();
+  NEXT;
+
+ op_define:
+  env->define(*pc++, vm_stack.back());
+  vm_stack.pop_back();
+  NEXT;
+
+ op_push_frame:
+  env = new Symbol_Table(env);
+  NEXT;
+
+ op_pop_frame:
+  env = env->parent_table;
+  NEXT;
+
+ op_pop:
+  vm_stack.pop_back();
+  NEXT;
+
+ op_jump:
+  pc = code + *pc;
+  NEXT;
+
+ op_jump_if_false:
+  a = vm_stack.back();
+  vm_stack.pop_back();
+  pc = bool_value(a) ? pc + 1 : code + *pc;
+  NEXT;
+
+ op_loop_test:
+  a = vm_stack.back();
+  vm_stack.pop_back();
+  if (!is_bool(a)) {
+    fprintf(stderr, "Error: while condition didn't evaluate to a boolean\n");
+    pc = code + *pc;
+  } else {
+    pc = a->val.b ? pc + 1 : code + *pc;
+  }
+  NEXT;
+
+ op_eval:
+  a = eval_parse_node(constants[*pc++], env);
+ push_eval:
+  if (is_return(a)) {
+    // a return inside a form the vm didn't compile
+    if (vm_frames.size() == frames.base) {
+      return a;
+    }
+    a = take_return();
+    goto return_a;
+  }
+  vm_stack.push_back(a);
+  NEXT;
+
+ op_prepare: {
+    Parse_Node *callee = env->bound_value(pc[0]);
+    bool expected;
+    if (callee == nullptr || node_type(callee) != PARSE_NODE_FUNCTION) {
+      expected = false;
+    } else if (pc[2] == 0) {
+      expected = (callee->subtype == FUNCTION_NATIVE);
+    } else {
+      expected = (callee == constants[pc[2] - 1]);
+    }
+    if (expected) {
+      vm_stack.push_back(callee);
+      pc += 4;
+    } else {
+      vm_stack.push_back(eval_parse_node(constants[pc[1]], env));
+      pc = code + pc[3];
+    }
+    NEXT;
+  }
+
+ op_macro:
+  if (env->bound_value(pc[0]) == constants[pc[1]] && pc[2] == current_macro_epoch()) {
+    pc += 5;
+    NEXT;
+  }
+  a = eval_parse_node(constants[pc[3]], env);
+  pc = code + pc[4];
+  goto push_eval;
+
+ op_call: {
+    uint32_t argc = *pc++;
+    size_t first = vm_stack.size() - argc;
+    Parse_Node *callee = vm_stack[first - 1];
+    Chunk *next = (callee->subtype == FUNCTION_NATIVE) ? function_chunk(callee) : nullptr;
+    if (next == nullptr || argc != next->params.size()) {
+      // builtins, lambda lists the vm doesn't bind, and arity errors
+      call_from_stack(argc, env);
+      NEXT;
+    }
+    check_call_depth();
+    Symbol_Table *frame = new Symbol_Table(callee->val.env);
+    for (uint32_t i = 0; i < argc; i++) {
+      frame->define(next->params[i], vm_stack[first + i]);
+    }
+    vm_frames.push_back(Frame{chunk, pc, first - 1});
+    vm_frame_envs.push_back(env);
+    call_depth++;
+    chunk = next;
+    code = chunk->code.data();
+    constants = chunk->constants.data();
+    pc = code;
+    env = frame;
+    NEXT;
+  }
+
+ op_tail_call: {
+    uint32_t argc = *pc++;
+    size_t first = vm_stack.size() - argc;
+    Parse_Node *callee = vm_stack[first - 1];
+    Chunk *next = function_chunk(callee);
+    if (next == nullptr || argc != next->params.size()) {
+      // lambda lists the vm doesn't bind, and arity errors
+      call_from_stack(argc, env);
+      NEXT;
+    }
+    Symbol_Table *frame = new Symbol_Table(callee->val.env);
+    for (uint32_t i = 0; i < argc; i++) {
+      frame->define(next->params[i], vm_stack[first + i]);
+    }
+    // the callee takes the place of the current function on the stack, it
+    // owns the chunk
+    vm_stack.resize((vm_frames.size() == frames.base) ? mark.base : vm_frames.back().base);
+    vm_stack.push_back(callee);
+    chunk = next;
+    code = chunk->code.data();
+    constants = chunk->constants.data();
+    pc = code;
+    env = frame;
+    NEXT;
+  }
+
+ op_add:
+  if (FIXNUM_OPERANDS()) {
+    REPLACE_CALL(make_integer(fixnum_value(a) + fixnum_value(b)));
+  } else {
+    call_from_stack(2, env);
+  }
+  NEXT;
+
+ op_sub:
+  if (FIXNUM_OPERANDS()) {
+    REPLACE_CALL(make_integer(fixnum_value(a) - fixnum_value(b)));
+  } else {
+    call_from_stack(2, env);
+  }
+  NEXT;
+
+ op_lt:
+  if (FIXNUM_OPERANDS()) {
+    REPLACE_CALL(fixnum_value(a) < fixnum_value(b) ? tru : fal);
+  } else {
+    call_from_stack(2, env);
+  }
+  NEXT;
+
+ op_le:
+  if (FIXNUM_OPERANDS()) {
+    REPLACE_CALL(fixnum_value(a) <= fixnum_value(b) ? tru : fal);
+  } else {
+    call_from_stack(2, env);
+  }
+  NEXT;
+
+ op_gt:
+  if (FIXNUM_OPERANDS()) {
+    REPLACE_CALL(fixnum_value(a) > fixnum_value(b) ? tru : fal);
+  } else {
+    call_from_stack(2, env);
+  }
+  NEXT;
+
+ op_ge:
+  if (FIXNUM_OPERANDS()) {
+    REPLACE_CALL(fixnum_value(a) >= fixnum_value(b) ? tru : fal);
+  } else {
+    call_from_stack(2, env);
+  }
+  NEXT;
+
+ op_eq:
+  if (FIXNUM_OPERANDS()) {
+    REPLACE_CALL(fixnum_value(a) == fixnum_value(b) ? tru : fal);
+  } else {
+    call_from_stack(2, env);
+  }
+  NEXT;
+
+ op_return:
+  a = vm_stack.back();
+ return_a:
+  if (vm_frames.size() == frames.base) {
+    return a;
+  }
+  vm_stack.resize(vm_frames.back().base);
+  vm_stack.push_back(a);
+  chunk = vm_frames.back().chunk;
+  code = chunk->code.data();
+  constants = chunk->constants.data();
+  pc = vm_frames.back().pc;
+  env = vm_frame_envs.back();
+  vm_frames.pop_back();
+  vm_frame_envs.pop_back();
+  call_depth--;
+  NEXT;
+
+#undef NEXT
+#undef FIXNUM_OPERANDS
+#undef REPLACE_CALL
+}
+
+Parse_Node *vm_eval(Parse_Node *form, Symbol_Table *env) {
+  Chunk chunk;
+  Compiler compiler{&chunk, env};
+  compiler.compile(form);
+  compiler.emit(OP_RETURN);
+  try {
+    return vm_run(&chunk, env);
+  } catch (runtimeError &e) {
+    return error_value(e.what());
+  }
+}
+
+Parse_Node *vm_apply(Parse_Node *fun, Parse_Node *node, Symbol_Table *env) {
+  if (function_chunk(fun) == nullptr) {
+    return apply_fun(fun, node, env);
+  }
+  Stack_Mark mark;
+  vm_stack.push_back(fun);
+  uint32_t argc = 0;
+  for (Parse_Node *arg = node->next; !is_empty_list(arg); arg = arg->next) {
+    Parse_Node *value = eval_parse_node(arg->first, env);
+    if (is_return(value)) {
+      return value;
+    }
+    vm_stack.push_back(value);
+    argc++;
+  }
+  return call_native(fun, mark.base + 1, argc);
+}
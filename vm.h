@@ -0,0 +1,47 @@
+#pragma once
+#include <vector>
+#include "parser.h"
+
+// Bytecode compiler and stack based virtual machine, enabled with
+// --engine=vm.
+//
+// Top level forms are compiled into a chunk and run, native functions are
+// compiled the first time the vm calls them and the chunk is kept until the
+// function is collected. Locals still live in Symbol_Table frames, so any
+// form the compiler doesn't handle is compiled into an OP_EVAL that hands it
+// to the tree-walker, in the same environment. Macros are expanded at
+// compile time, the expansion guarded by the macro and the macro epoch,
+// and a function chunk holding expansions is compiled again once a macro
+// has been defined.
+
+// switches to the vm engine, before anything is evaluated
+void vm_init();
+
+struct Chunk {
+  std::vector<uint32_t> code;
+  // every node the code refers to, rooted for as long as the chunk lives
+  std::vector<Parse_Node *> constants;
+  // parameter ids of a function chunk, in binding order
+  std::vector<uint32_t> params;
+  // set if the code has macro expansions, made in macro_epoch
+  bool expands_macros = false;
+  uint32_t macro_epoch = 0;
+  // the chunk this one replaced, which may still be running
+  Chunk *stale = nullptr;
+
+  Chunk() { gc_add_root(&constants); }
+  ~Chunk() {
+    gc_remove_root(&constants);
+    delete stale;
+  }
+  Chunk(const Chunk &) = delete;
+  Chunk &operator=(const Chunk &) = delete;
+};
+
+Parse_Node *vm_eval(Parse_Node *form, Symbol_Table *env);
+
+// call of a native function from the tree-walker, node is the whole call form
+Parse_Node *vm_apply(Parse_Node *fun, Parse_Node *node, Symbol_Table *env);
+
+// called by the collector when a function with NODE_HAS_CHUNK is freed
+void vm_forget_chunk(Parse_Node *fun);